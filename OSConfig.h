@@ -0,0 +1,29 @@
+/*
+ * Compile time configuration for the OS
+ * set a feature to 0 to compile it out entirely
+ */
+#ifndef OS_CONFIG_H
+#define OS_CONFIG_H
+
+#ifndef configCPU_CLOCK_HZ
+#define configCPU_CLOCK_HZ (80000000)	// 80 Mhz clock frequency
+#endif
+#define configTICK_RATE_HZ (1000)       // 1000 hz tick rate
+
+// per mutex acquisition, contention, wait and hold time statistics
+// reported over serial by mutex_profile_report
+#define configUSE_MUTEX_PROFILING 0
+
+// walk the owner -> blocked on chain whenever a thread blocks on a mutex 
+// and report lock cycles over serial as soon as they form
+#define configUSE_DEADLOCK_DETECTION 0
+
+// save the floating point registers of threads that use the FPU,
+// on by default whenever the compiler targets a hardware FPU (Cortex-M4F)
+#ifdef __ARM_FP
+#define configUSE_FPU 1
+#else
+#define configUSE_FPU 0
+#endif
+
+#endif /* OS_CONFIG_H */
@@ -0,0 +1,48 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include "barrier.h"
+#include <stdlib.h>
+
+barrier_t create_barrier(uint32_t parties) {
+    barrier_t res = MALLOC(sizeof(struct barrier));
+    if (!res) return NULL;
+    res->parties = parties;
+    res->arrived = 0;
+    res->generation = 0;
+    res->waitList = NULL;
+    return res;
+}
+
+void free_barrier(barrier_t barrier) {
+    FREE(barrier);
+}
+
+bool barrier_wait(barrier_t barrier) {
+    DISABLE_INTERRUPTS();
+    uint32_t generation = barrier->generation;
+    barrier->arrived++;
+    if (barrier->arrived < barrier->parties) {
+        // only the release of this generation lets the thread through,
+        // anything else that wakes it puts it straight back to sleep
+        do {
+            OS_blockCurrentTask(&barrier->waitList, OS_WAIT_FOREVER);
+            ENABLE_INTERRUPTS();
+            DISABLE_INTERRUPTS();
+        } while (barrier->generation == generation);
+        ENABLE_INTERRUPTS();
+        return false;
+    }
+
+    // last one in: start the next generation and release everyone
+    bool switchNeeded = false;
+    barrier->arrived = 0;
+    barrier->generation++;
+    while (barrier->waitList != NULL) {
+        if (OS_unblockTaskFromISR(OS_waitListHead(barrier->waitList)))
+            switchNeeded = true;
+    }
+    ENABLE_INTERRUPTS();
+    if (switchNeeded) OS_yield();
+    return true;
+}
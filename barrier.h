@@ -0,0 +1,45 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include <stdlib.h>
+
+#ifndef BARRIERS
+#define BARRIERS
+
+/*
+ * Barrier for a fixed number of threads (parties): each one blocks in
+ * barrier_wait until all of them have arrived, then the last one to 
+ * arrive releases the rest in one pass. The arrival count starts over on
+ * every release, so the barrier can be reused phase after phase without
+ * re-initializing it. Waiters only leave once the generation they arrived
+ * in has been released, so an early wake cannot let one through.
+ */
+struct barrier
+{
+    uint32_t parties;       // threads that have to arrive to release the barrier
+    uint32_t arrived;       // threads that arrived in the current generation
+    uint32_t generation;    // incremented every time the barrier is released, 
+                            // waiters wait for it to change
+    list_t waitList;        // threads blocked on the barrier
+};
+
+typedef struct barrier *barrier_t;
+
+/*
+ * REQUIRES: parties > 0
+ */
+barrier_t create_barrier(uint32_t parties);
+
+/*
+ * REQUIRES: no thread is blocked on the barrier
+ */
+void free_barrier(barrier_t barrier);
+
+/*
+ * Blocks until parties threads have called barrier_wait in this generation.
+ * Returns true in exactly one thread per generation, the last one to arrive,
+ * e.g. to do the work between two phases.
+ */
+bool barrier_wait(barrier_t barrier);
+
+#endif
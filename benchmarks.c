@@ -0,0 +1,427 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "serial.h"
+#include "scheduler.h"
+#include "mutex.h"
+#include "semaphore.h"
+#include "rwlock.h"
+#include "queue.h"
+#include "benchmarks.h"
+
+#define BENCH_STACK_SIZE 200
+#define BENCH_WINDOW_TICKS 1000		// 1s at the 1000 hz tick rate
+#define BENCH_CONTROLLER_TID 100
+#define BENCH_READER_TID 101
+#define BENCH_MAX_READERS 8
+#define BENCH_TABLE_SIZE 16
+#define BENCH_ITERATIONS 1000
+#define BENCH_PING_TID 110
+#define BENCH_PONG_TID 111
+#define BENCH_NOTIFY_PING_TID 112
+#define BENCH_NOTIFY_PONG_TID 113
+#define BENCH_SWITCH_A_TID 114
+#define BENCH_SWITCH_B_TID 115
+#define BENCH_ISR_TID 116
+#define BENCH_TRIGGER_TID 117
+#define BENCH_MUTEX_WAITER_TID 118
+#define BENCH_MUTEX_OWNER_TID 119
+#define BENCH_RECEIVER_TID 120
+#define BENCH_SENDER_TID 121
+#define BENCH_SUITE_TID 122
+
+/*
+ * min / mean / max of a latency in CYCLE_COUNT units
+ */
+struct benchStats {
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	uint32_t samples;
+};
+
+static void statsReset(struct benchStats* stats) {
+	stats->min = 0xFFFFFFFF;
+	stats->max = 0;
+	stats->total = 0;
+	stats->samples = 0;
+}
+
+static void statsAdd(struct benchStats* stats, uint32_t cycles) {
+	if (cycles < stats->min) stats->min = cycles;
+	if (cycles > stats->max) stats->max = cycles;
+	stats->total += cycles;
+	stats->samples++;
+}
+
+static void statsReport(char* label, struct benchStats* stats) {
+	SerialWrite(label);
+	SerialWrite(" min/mean/max: ");
+	SerialWriteUnsigned(stats->min);
+	SerialWrite("/");
+	SerialWriteUnsigned(stats->samples ? (uint32_t)(stats->total / stats->samples) : 0);
+	SerialWrite("/");
+	SerialWriteUnsigned(stats->max);
+	SerialWrite(" ");
+	SerialWriteLine(portCYCLE_COUNT_UNIT);
+}
+
+// signalled by each benchmark as it finishes while BENCH_latencySuite runs
+static csemaphore_t suiteDone = NULL;
+
+/*
+ * parks the calling benchmark thread for good
+ */
+static void benchPark(void) {
+	while (1) OS_Delay(BENCH_WINDOW_TICKS);
+}
+
+/*
+ * called by the thread that reports a benchmark, once it has
+ */
+static void benchDone(void) {
+	if (suiteDone != NULL) OS_Signal(suiteDone);
+	benchPark();
+}
+
+/*
+ * rwlock read throughput
+ * every reader thread is spawned up front, the controller then lets 1 to 8 of 
+ * them read for one window at a time and sums up how many reads they got done
+ */
+static rwlock_t benchRwlock;
+static mutex_t benchMutex;
+static volatile bool benchUseRwlock = true;
+static volatile uint32_t activeReaders = 0;
+static volatile uint32_t readCounts[BENCH_MAX_READERS];
+static volatile uint32_t sharedTable[BENCH_TABLE_SIZE];
+
+static uint32_t readTable(void) {
+	uint32_t sum = 0;
+	for (int i = 0; i < BENCH_TABLE_SIZE; i++)
+		sum += sharedTable[i];
+	return sum;
+}
+
+static void benchReader(void) {
+	uint32_t id = pxCurrentTCB->uxThreadId - BENCH_READER_TID;
+	while (1) {
+		if (id >= activeReaders) {
+			OS_Delay(1);
+			continue;
+		}
+		if (benchUseRwlock) {
+			acquire_read(benchRwlock);
+			readTable();
+			release_read(benchRwlock);
+		}
+		else {
+			acquire_mutex(benchMutex, id, 1);
+			readTable();
+			release_mutex(benchMutex, id, 1);
+		}
+		readCounts[id]++;
+	}
+}
+
+static uint32_t runReadWindow(uint32_t readers) {
+	uint32_t total = 0;
+	// park every reader before the counts are reset
+	activeReaders = 0;
+	OS_Delay(2);
+	for (int i = 0; i < BENCH_MAX_READERS; i++)
+		readCounts[i] = 0;
+	
+	activeReaders = readers;
+	OS_Delay(BENCH_WINDOW_TICKS);
+	activeReaders = 0;
+	
+	for (int i = 0; i < BENCH_MAX_READERS; i++)
+		total += readCounts[i];
+	return total;
+}
+
+static void rwlockBenchController(void) {
+	for (int pass = 0; pass < 2; pass++) {
+		benchUseRwlock = (pass == 0);
+		SerialWriteLine(benchUseRwlock ? "rwlock read throughput (reads/s):" 
+									   : "mutex read throughput (reads/s):");
+		for (uint32_t readers = 1; readers <= BENCH_MAX_READERS; readers++) {
+			uint32_t reads = runReadWindow(readers);
+			SerialWrite("  readers: ");
+			SerialWriteInt(readers);
+			SerialWrite("  reads: ");
+			SerialWriteInt(reads);
+		}
+	}
+	SerialWriteLine("rwlock benchmark done");
+	benchDone();
+}
+
+void BENCH_rwlockReadThroughput(void) {
+	benchRwlock = create_rwlock(true);
+	benchMutex = create_mutex();
+	for (int i = 0; i < BENCH_TABLE_SIZE; i++)
+		sharedTable[i] = i;
+	
+	// the controller outranks the readers so it always wakes up on time
+	OS_spawnThread(&rwlockBenchController, BENCH_CONTROLLER_TID, BENCH_STACK_SIZE, 0);
+	for (int i = 0; i < BENCH_MAX_READERS; i++)
+		OS_spawnThread(&benchReader, BENCH_READER_TID + i, BENCH_STACK_SIZE, 1);
+}
+
+/*
+ * semaphore ping-pong
+ * ping and pong run at the same priority, so every round trip is
+ * two blocking waits and two context switches
+ */
+static csemaphore_t pingSemaphore;
+static csemaphore_t pongSemaphore;
+
+static void benchPong(void) {
+	while (1) {
+		OS_Wait(pingSemaphore);
+		OS_Signal(pongSemaphore);
+	}
+}
+
+static void benchPing(void) {
+	struct benchStats stats;
+	statsReset(&stats);
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		uint32_t start = CYCLE_COUNT();
+		OS_Signal(pingSemaphore);
+		OS_Wait(pongSemaphore);
+		statsAdd(&stats, CYCLE_COUNT() - start);
+	}
+	statsReport("semaphore ping-pong round trip", &stats);
+	benchDone();
+}
+
+void BENCH_semaphorePingPong(void) {
+	pingSemaphore = create_semaphore(0, WAIT_ORDER_FIFO);
+	pongSemaphore = create_semaphore(0, WAIT_ORDER_FIFO);
+	OS_spawnThread(&benchPing, BENCH_PING_TID, BENCH_STACK_SIZE, 1);
+	OS_spawnThread(&benchPong, BENCH_PONG_TID, BENCH_STACK_SIZE, 1);
+}
+
+/*
+ * notification ping-pong
+ * the same round trip with the notification word standing in for the semaphores
+ */
+static TCB_t* notifyPingThread;
+static TCB_t* notifyPongThread;
+
+static void benchNotifyPong(void) {
+	while (1) {
+		OS_NotifyTake(false, OS_WAIT_FOREVER);
+		OS_Notify(notifyPingThread, 0, NOTIFY_INCREMENT);
+	}
+}
+
+static void benchNotifyPing(void) {
+	struct benchStats stats;
+	statsReset(&stats);
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		uint32_t start = CYCLE_COUNT();
+		OS_Notify(notifyPongThread, 0, NOTIFY_INCREMENT);
+		OS_NotifyTake(false, OS_WAIT_FOREVER);
+		statsAdd(&stats, CYCLE_COUNT() - start);
+	}
+	statsReport("notification ping-pong round trip", &stats);
+	benchDone();
+}
+
+void BENCH_notifyPingPong(void) {
+	notifyPingThread = OS_spawnThread(&benchNotifyPing, BENCH_NOTIFY_PING_TID, BENCH_STACK_SIZE, 1);
+	notifyPongThread = OS_spawnThread(&benchNotifyPong, BENCH_NOTIFY_PONG_TID, BENCH_STACK_SIZE, 1);
+}
+
+/*
+ * context switch
+ * two threads at the top priority yield to each other, each one timing 
+ * the switch from the stamp the other took just before yielding
+ */
+static volatile uint32_t switchStamp;
+static volatile bool switchDone = false;
+
+static void benchSwitchB(void) {
+	while (!switchDone) {
+		switchStamp = CYCLE_COUNT();
+		OS_yield();
+	}
+	benchPark();
+}
+
+static void benchSwitchA(void) {
+	struct benchStats stats;
+	statsReset(&stats);
+	// the first yield only gets B going
+	switchStamp = CYCLE_COUNT();
+	OS_yield();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		// stamp first: if a tick lets B run in between, B stamps again
+		// and the difference would wrap around
+		uint32_t stamp = switchStamp;
+		statsAdd(&stats, CYCLE_COUNT() - stamp);
+		OS_yield();
+	}
+	switchDone = true;
+	statsReport("yield to next thread", &stats);
+	benchDone();
+}
+
+void BENCH_contextSwitch(void) {
+	OS_spawnThread(&benchSwitchA, BENCH_SWITCH_A_TID, BENCH_STACK_SIZE, 0);
+	OS_spawnThread(&benchSwitchB, BENCH_SWITCH_B_TID, BENCH_STACK_SIZE, 0);
+}
+
+/*
+ * ISR to task
+ * a low priority thread stamps and triggers the interrupt, whose handler
+ * signals the top priority thread, which takes the difference
+ */
+static csemaphore_t isrSemaphore;
+static volatile uint32_t isrStamp;
+static volatile bool isrDone = false;
+
+void portTEST_IRQHandler(void) {
+	bool woken = false;
+	OS_SignalFromISR(isrSemaphore, &woken);
+	OS_YIELD_FROM_ISR(woken);
+}
+
+static void benchTrigger(void) {
+	while (!isrDone) {
+		isrStamp = CYCLE_COUNT();
+		portTRIGGER_TEST_INTERRUPT();
+	}
+	benchPark();
+}
+
+static void benchIsrWaiter(void) {
+	struct benchStats stats;
+	statsReset(&stats);
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		OS_Wait(isrSemaphore);
+		statsAdd(&stats, CYCLE_COUNT() - isrStamp);
+	}
+	isrDone = true;
+	statsReport("interrupt to task", &stats);
+	benchDone();
+}
+
+void BENCH_isrToTask(void) {
+	isrSemaphore = create_semaphore(0, WAIT_ORDER_FIFO);
+	portSETUP_TEST_INTERRUPT();
+	OS_spawnThread(&benchIsrWaiter, BENCH_ISR_TID, BENCH_STACK_SIZE, 0);
+	OS_spawnThread(&benchTrigger, BENCH_TRIGGER_TID, BENCH_STACK_SIZE, 1);
+}
+
+/*
+ * mutex handoff
+ * the owner wakes the waiter, which blocks on the mutex, then stamps and
+ * releases it straight to the waiter
+ */
+static mutex_t handoffMutex;
+static csemaphore_t handoffReady;
+static volatile uint32_t handoffStamp;
+static volatile bool handoffDone = false;
+
+static void benchMutexOwner(void) {
+	while (!handoffDone) {
+		acquire_mutex(handoffMutex, BENCH_MUTEX_OWNER_TID, 1);
+		OS_Signal(handoffReady);
+		handoffStamp = CYCLE_COUNT();
+		release_mutex(handoffMutex, BENCH_MUTEX_OWNER_TID, 1);
+	}
+	benchPark();
+}
+
+static void benchMutexWaiter(void) {
+	struct benchStats stats;
+	statsReset(&stats);
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		OS_Wait(handoffReady);
+		acquire_mutex(handoffMutex, BENCH_MUTEX_WAITER_TID, 0);
+		statsAdd(&stats, CYCLE_COUNT() - handoffStamp);
+		release_mutex(handoffMutex, BENCH_MUTEX_WAITER_TID, 0);
+	}
+	handoffDone = true;
+	statsReport("mutex handoff", &stats);
+	benchDone();
+}
+
+void BENCH_mutexHandoff(void) {
+	handoffMutex = create_mutex();
+	handoffReady = create_semaphore(0, WAIT_ORDER_FIFO);
+	OS_spawnThread(&benchMutexWaiter, BENCH_MUTEX_WAITER_TID, BENCH_STACK_SIZE, 0);
+	OS_spawnThread(&benchMutexOwner, BENCH_MUTEX_OWNER_TID, BENCH_STACK_SIZE, 1);
+}
+
+/*
+ * queue send to receive
+ * the receiver is blocked on an empty queue every time the sender sends,
+ * so each message is handed over directly
+ */
+static queue_t benchQueue;
+static QUEUE_STORAGE(benchQueueStorage, sizeof(uint32_t), 4);
+static volatile bool queueDone = false;
+
+static void benchSender(void) {
+	while (!queueDone) {
+		uint32_t stamp = CYCLE_COUNT();
+		queue_send(benchQueue, &stamp, OS_WAIT_FOREVER);
+	}
+	benchPark();
+}
+
+static void benchReceiver(void) {
+	struct benchStats stats;
+	statsReset(&stats);
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		uint32_t stamp;
+		queue_receive(benchQueue, &stamp, OS_WAIT_FOREVER);
+		statsAdd(&stats, CYCLE_COUNT() - stamp);
+	}
+	queueDone = true;
+	statsReport("queue send to receive", &stats);
+	benchDone();
+}
+
+void BENCH_queueSendToReceive(void) {
+	benchQueue = create_queue(benchQueueStorage, sizeof(uint32_t), 4);
+	OS_spawnThread(&benchReceiver, BENCH_RECEIVER_TID, BENCH_STACK_SIZE, 0);
+	OS_spawnThread(&benchSender, BENCH_SENDER_TID, BENCH_STACK_SIZE, 1);
+}
+
+/*
+ * latency suite
+ * a controller below the benchmark threads starts each benchmark in turn
+ * and waits for it to report before starting the next one
+ */
+static void (* const suite[])(void) = {
+	&BENCH_contextSwitch,
+	&BENCH_isrToTask,
+	&BENCH_mutexHandoff,
+	&BENCH_semaphorePingPong,
+	&BENCH_notifyPingPong,
+	&BENCH_queueSendToReceive,
+};
+
+static void suiteController(void) {
+	for (uint32_t i = 0; i < sizeof(suite) / sizeof(suite[0]); i++) {
+		// spawning touches the ready lists
+		DISABLE_INTERRUPTS();
+		suite[i]();
+		ENABLE_INTERRUPTS();
+		OS_Wait(suiteDone);
+	}
+	SerialWriteLine("latency suite done");
+	benchPark();
+}
+
+void BENCH_latencySuite(void) {
+	suiteDone = create_semaphore(0, WAIT_ORDER_FIFO);
+	OS_spawnThread(&suiteController, BENCH_SUITE_TID, BENCH_STACK_SIZE, 2);
+}
@@ -0,0 +1,62 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+/*
+ * Benchmarks for the kernel primitives.
+ * Each one spawns its own threads and reports over the serial port.
+ * Define RUN_BENCHMARKS as the one to run, e.g. RUN_BENCHMARKS=BENCH_semaphorePingPong,
+ * and main calls it in place of spawning the demo threads. The Benchmarks
+ * target of the Keil project builds BENCH_latencySuite this way.
+ * Latencies are measured with the port's CYCLE_COUNT (the DWT cycle
+ * counter on the board) and reported as min/mean/max over BENCH_ITERATIONS
+ * runs, in portCYCLE_COUNT_UNIT.
+ */
+
+/*
+ * Reads per second of a shared table by 1 to 8 reader threads,
+ * through an rwlock and, for comparison, through a mutex
+ */
+void BENCH_rwlockReadThroughput(void);
+
+/*
+ * Round trip latency, in cycles, of two threads signalling each other 
+ * through a pair of blocking semaphores
+ */
+void BENCH_semaphorePingPong(void);
+
+/*
+ * Same round trip as BENCH_semaphorePingPong, through direct to task
+ * notifications instead of semaphores
+ */
+void BENCH_notifyPingPong(void);
+
+/*
+ * Cycles from one thread calling OS_yield to the next thread running,
+ * i.e. the cost of one pass through PendSV
+ */
+void BENCH_contextSwitch(void);
+
+/*
+ * Cycles from an interrupt being triggered to the thread it signals 
+ * running, through OS_SignalFromISR and OS_YIELD_FROM_ISR
+ */
+void BENCH_isrToTask(void);
+
+/*
+ * Cycles from release_mutex to the higher priority thread blocked
+ * on the mutex running with it
+ */
+void BENCH_mutexHandoff(void);
+
+/*
+ * Cycles from queue_send to the higher priority thread blocked in 
+ * queue_receive running with the message
+ */
+void BENCH_queueSendToReceive(void);
+
+/*
+ * Runs every latency benchmark above, one after the other
+ */
+void BENCH_latencySuite(void);
+
+#endif /* BENCHMARKS_H */
@@ -0,0 +1,53 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include "mutex.h"
+#include "condvar.h"
+#include <stdlib.h>
+
+condvar_t create_condvar() {
+    condvar_t res = MALLOC(sizeof(struct condvar));
+    if (!res) return NULL;
+    res->waitList = NULL;
+    return res;
+}
+
+void free_condvar(condvar_t cond) {
+    FREE(cond);
+}
+
+void cond_wait(condvar_t cond, mutex_t mutex) {
+    cond_wait_timeout(cond, mutex, OS_WAIT_FOREVER);
+}
+
+bool cond_wait_timeout(condvar_t cond, mutex_t mutex, uint32_t ticks) {
+    DISABLE_INTERRUPTS();
+    // we are about to block, so any switch to the new owner happens then
+    release_mutex_locked(mutex);
+    OS_blockCurrentTask(&cond->waitList, ticks);
+    ENABLE_INTERRUPTS();
+
+    bool signalled = !pxCurrentTCB->xTimedOut;
+    acquire_mutex(mutex, pxCurrentTCB->uxThreadId, pxCurrentTCB->uxPriority);
+    return signalled;
+}
+
+void cond_signal(condvar_t cond) {
+    DISABLE_INTERRUPTS();
+    bool switchNeeded = false;
+    TCB_t* next = OS_waitListHead(cond->waitList);
+    if (next != NULL) switchNeeded = OS_unblockTaskFromISR(next);
+    ENABLE_INTERRUPTS();
+    if (switchNeeded) OS_yield();
+}
+
+void cond_broadcast(condvar_t cond) {
+    DISABLE_INTERRUPTS();
+    bool switchNeeded = false;
+    while (cond->waitList != NULL) {
+        if (OS_unblockTaskFromISR(OS_waitListHead(cond->waitList)))
+            switchNeeded = true;
+    }
+    ENABLE_INTERRUPTS();
+    if (switchNeeded) OS_yield();
+}
@@ -0,0 +1,57 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include "mutex.h"
+#include <stdlib.h>
+
+#ifndef CONDVARS
+#define CONDVARS
+
+/*
+ * Condition variable, used together with a mutex_t guarding the condition:
+ *
+ *     acquire_mutex(m, id, priority);
+ *     while (!condition) cond_wait(cond, m);
+ *     ...
+ *     release_mutex(m, id, priority);
+ */
+struct condvar
+{
+    list_t waitList;    // threads blocked on the condition, highest priority first
+};
+
+typedef struct condvar *condvar_t;
+
+condvar_t create_condvar();
+
+/*
+ * REQUIRES: no thread is blocked on the condition variable
+ */
+void free_condvar(condvar_t cond);
+
+/*
+ * Releases mutex and blocks on cond in one step, so a signal sent right
+ * after the release cannot be missed, then re-acquires mutex before
+ * returning.
+ * REQUIRES: the caller owns mutex (only once, if it is recursive)
+ */
+void cond_wait(condvar_t cond, mutex_t mutex);
+
+/*
+ * Same as cond_wait, but stops waiting after ticks system ticks.
+ * Returns true if signalled, false on timeout. The mutex is re-acquired
+ * either way.
+ */
+bool cond_wait_timeout(condvar_t cond, mutex_t mutex, uint32_t ticks);
+
+/*
+ * Wakes the highest priority waiter
+ */
+void cond_signal(condvar_t cond);
+
+/*
+ * Wakes every waiter
+ */
+void cond_broadcast(condvar_t cond);
+
+#endif
@@ -0,0 +1,122 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include "eventgroup.h"
+#include <stdlib.h>
+
+/*
+ * what a blocked thread is waiting for, lives on its stack
+ */
+struct eventWaiter
+{
+    uint32_t bits;
+    bool waitAll;
+    bool clearOnExit;
+    uint32_t result;    // the group's bits when the waiter was woken
+};
+
+static bool satisfied(uint32_t groupBits, uint32_t bits, bool waitAll) {
+    if (waitAll) return (groupBits & bits) == bits;
+    return (groupBits & bits) != 0;
+}
+
+eventgroup_t create_event_group() {
+    eventgroup_t res = MALLOC(sizeof(struct eventGroup));
+    if (!res) return NULL;
+    res->bits = 0;
+    res->waitList = NULL;
+    return res;
+}
+
+void free_event_group(eventgroup_t group) {
+    FREE(group);
+}
+
+/*
+ * sets bits and wakes every satisfied waiter in one pass,
+ * returns true if one of them outranks the running thread
+ * REQUIRES: interrupts are disabled
+ */
+static bool setBits(eventgroup_t group, uint32_t bits, uint32_t* result) {
+    bool switchNeeded = false;
+    uint32_t toClear = 0;
+    group->bits |= bits;
+    *result = group->bits;
+
+    list_t node = group->waitList;
+    if (node != NULL) {
+        list_t last = node->prev;
+        while (1) {
+            // waking a waiter unlinks its node, so step along first
+            list_t next = node->next;
+            bool isLast = (node == last);
+            TCB_t* task = (TCB_t*)node->data;
+            struct eventWaiter* waiter = task->pvWaitData;
+            if (satisfied(group->bits, waiter->bits, waiter->waitAll)) {
+                waiter->result = group->bits;
+                if (waiter->clearOnExit) toClear |= waiter->bits;
+                if (OS_unblockTaskFromISR(task)) switchNeeded = true;
+            }
+            if (isLast) break;
+            node = next;
+        }
+    }
+    group->bits &= ~toClear;
+    return switchNeeded;
+}
+
+uint32_t event_group_set_bits(eventgroup_t group, uint32_t bits) {
+    uint32_t result;
+    DISABLE_INTERRUPTS();
+    bool switchNeeded = setBits(group, bits, &result);
+    ENABLE_INTERRUPTS();
+    if (switchNeeded) OS_yield();
+    return result;
+}
+
+uint32_t event_group_set_bits_from_isr(eventgroup_t group, uint32_t bits,
+                                       bool* higherPriorityTaskWoken) {
+    uint32_t result;
+    uint32_t previous = DISABLE_INTERRUPTS_FROM_ISR();
+    if (setBits(group, bits, &result)) *higherPriorityTaskWoken = true;
+    ENABLE_INTERRUPTS_FROM_ISR(previous);
+    return result;
+}
+
+uint32_t event_group_clear_bits(eventgroup_t group, uint32_t bits) {
+    DISABLE_INTERRUPTS();
+    uint32_t result = group->bits;
+    group->bits &= ~bits;
+    ENABLE_INTERRUPTS();
+    return result;
+}
+
+uint32_t event_group_get_bits(eventgroup_t group) {
+    return group->bits;
+}
+
+uint32_t event_group_wait_bits(eventgroup_t group, uint32_t bits, bool waitAll,
+                               bool clearOnExit, uint32_t ticks) {
+    struct eventWaiter waiter;
+    DISABLE_INTERRUPTS();
+    uint32_t result = group->bits;
+    if (satisfied(result, bits, waitAll)) {
+        if (clearOnExit) group->bits &= ~bits;
+        ENABLE_INTERRUPTS();
+        return result;
+    }
+    if (ticks == 0) {
+        ENABLE_INTERRUPTS();
+        return result;
+    }
+    waiter.bits = bits;
+    waiter.waitAll = waitAll;
+    waiter.clearOnExit = clearOnExit;
+    pxCurrentTCB->pvWaitData = &waiter;
+    OS_blockCurrentTask(&group->waitList, ticks);
+    ENABLE_INTERRUPTS();
+
+    pxCurrentTCB->pvWaitData = NULL;
+    if (pxCurrentTCB->xTimedOut) return group->bits;
+    return waiter.result;
+}
@@ -0,0 +1,57 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include <stdlib.h>
+
+#ifndef EVENT_GROUPS
+#define EVENT_GROUPS
+
+/*
+ * 32 event flags that threads can block on until any or all of a set 
+ * of them are set. Setting bits wakes every waiter it satisfies in a
+ * single pass over the wait list.
+ */
+struct eventGroup
+{
+    volatile uint32_t bits;
+    list_t waitList;        // threads blocked on the group, highest priority first
+};
+
+typedef struct eventGroup *eventgroup_t;
+
+eventgroup_t create_event_group();
+
+/*
+ * REQUIRES: no thread is blocked on the group
+ */
+void free_event_group(eventgroup_t group);
+
+/*
+ * Sets bits and wakes every waiter that is now satisfied.
+ * Returns the bits as they were right after setting, before any waiter
+ * cleared its bits on exit.
+ */
+uint32_t event_group_set_bits(eventgroup_t group, uint32_t bits);
+
+/*
+ * event_group_set_bits for interrupt handlers, see OS_SignalFromISR
+ */
+uint32_t event_group_set_bits_from_isr(eventgroup_t group, uint32_t bits,
+                                       bool* higherPriorityTaskWoken);
+
+/*
+ * Returns the bits as they were before clearing
+ */
+uint32_t event_group_clear_bits(eventgroup_t group, uint32_t bits);
+uint32_t event_group_get_bits(eventgroup_t group);
+
+/*
+ * Waits until any (or, with waitAll, all) of bits are set in the group.
+ * With clearOnExit the bits waited for are cleared when the wait succeeds.
+ * Returns the group's bits when the wait ended, so the caller can tell
+ * which events happened, or that it timed out if the condition does not hold.
+ */
+uint32_t event_group_wait_bits(eventgroup_t group, uint32_t bits, bool waitAll,
+                               bool clearOnExit, uint32_t ticks);
+
+#endif
@@ -124,4 +124,35 @@ list_t delete_node(list_t node) {
     list_t res = node->next;
     FREE(node);
     return res;
+}
+
+/*
+ * links an already allocated node in as the next of current node of a 
+ * circular list, without allocating
+ */
+list_t link_as_next(list_t current_node, list_t node) {
+    if (current_node == NULL) {
+        node->next = node;
+        node->prev = node;
+        return node;
+    }
+    node->next = current_node->next;
+    node->prev = current_node;
+    node->next->prev = node;
+    current_node->next = node;
+    return node;
+}
+
+/*
+ * unlinks node from its circular list without freeing it
+ * Returns NULL if node was the only node in its list
+ */
+list_t unlink_node(list_t node) {
+    if (node->next == node) return NULL;
+    list_t res = node->next;
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = node;
+    node->prev = node;
+    return res;
 }
\ No newline at end of file
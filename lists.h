@@ -54,4 +54,21 @@ list_t add_to_back(list_t lst, void *data);
  */
 list_t delete_node(list_t node);
 
+/*
+ * links an already allocated node in as the next of current node of a 
+ * circular list. Nothing is allocated, so this is safe to call from the
+ * kernel with interrupts disabled.
+ * If current_node is NULL, node becomes a singleton circular list.
+ * returns node
+ */
+list_t link_as_next(list_t current_node, list_t node);
+
+/*
+ * unlinks node from its circular list without freeing it, leaving node 
+ * as a singleton circular list that can be linked in elsewhere.
+ * Returns the next node of the unlinked node
+ * Returns NULL if node was the only node in its list
+ */
+list_t unlink_node(list_t node);
+
 #endif
\ No newline at end of file
@@ -6,18 +6,22 @@
 
 void linearListTests();
 void circularListTests();
+void linkUnlinkTests();
 
 char mallocArray[1000];
 
 int main() {
     printf("Running tests...\n");
-    initMalloc(mallocArray);
+    initMalloc(mallocArray, sizeof(mallocArray));
     printf("Running circular linked list tests...");
     circularListTests();
     printf(" Passed!\n");
     printf("Running linear linked list tests...");
     linearListTests();
     printf(" Passed!\n");
+    printf("Running link/unlink tests...");
+    linkUnlinkTests();
+    printf(" Passed!\n");
     printf("All tests passed!\n");
     return 0;
 }
@@ -67,4 +71,30 @@ void circularListTests() {
     //printf("final node: 0x%x\n", (unsigned int)testList->next);
 }
 
+void linkUnlinkTests() {
+    int nums[3] = {1,2,3};
+    list_t a = create_circular_list((void *)&nums[0]);
+    list_t b = create_circular_list((void *)&nums[1]);
+    list_t c = create_circular_list((void *)&nums[2]);
+    list_t testList = link_as_next(NULL, a);
+    assert(testList == a && a->next == a && a->prev == a);
+    link_as_next(a, b);
+    link_as_next(b, c);
+    for (int i = 0; i < 6; i++) {
+        assert(nums[i%3] == *(int *)testList->data);
+        assert(testList->next->prev == testList);
+        testList = testList->next;
+    }
+    // unlinking the middle node keeps the ring intact
+    assert(unlink_node(b) == c);
+    assert(b->next == b && b->prev == b);
+    assert(a->next == c && c->prev == a && c->next == a);
+    // the unlinked node can be moved to another spot without allocating
+    link_as_next(c, b);
+    assert(c->next == b && b->next == a && a->prev == b);
+    assert(unlink_node(a) == c);
+    assert(unlink_node(c) == b);
+    assert(unlink_node(b) == NULL);
+}
+
 // TODO: delete node tests
\ No newline at end of file
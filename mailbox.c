@@ -0,0 +1,106 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include "queue.h"
+#include "mailbox.h"
+#include <stdlib.h>
+
+pool_t create_pool(void* storage, uint32_t bufferSize, uint32_t count) {
+    pool_t res = MALLOC(sizeof(struct bufferPool));
+    if (!res) return NULL;
+    void* pointers = MALLOC(count * sizeof(void*));
+    if (!pointers) {
+        FREE(res);
+        return NULL;
+    }
+    res->freeBuffers = create_queue(pointers, sizeof(void*), count);
+    if (!res->freeBuffers) {
+        FREE(pointers);
+        FREE(res);
+        return NULL;
+    }
+    res->bufferSize = (bufferSize + 3) & ~3UL;
+
+    // every buffer starts out free
+    for (uint32_t i = 0; i < count; i++) {
+        void* buffer = &((uint8_t*)storage)[i * res->bufferSize];
+        queue_send(res->freeBuffers, &buffer, 0);
+    }
+    return res;
+}
+
+void free_pool(pool_t pool) {
+    FREE(pool->freeBuffers->storage);
+    free_queue(pool->freeBuffers);
+    FREE(pool);
+}
+
+void* pool_alloc(pool_t pool, uint32_t ticks) {
+    void* buffer;
+    if (!queue_receive(pool->freeBuffers, &buffer, ticks)) return NULL;
+    return buffer;
+}
+
+void pool_free(pool_t pool, void* buffer) {
+    // there is a slot for every buffer, so this never blocks
+    queue_send(pool->freeBuffers, &buffer, 0);
+}
+
+void* pool_alloc_from_isr(pool_t pool, bool* higherPriorityTaskWoken) {
+    void* buffer;
+    if (!queue_receive_from_isr(pool->freeBuffers, &buffer, higherPriorityTaskWoken)) 
+        return NULL;
+    return buffer;
+}
+
+void pool_free_from_isr(pool_t pool, void* buffer, bool* higherPriorityTaskWoken) {
+    queue_send_from_isr(pool->freeBuffers, &buffer, higherPriorityTaskWoken);
+}
+
+uint32_t pool_free_count(pool_t pool) {
+    return queue_messages_waiting(pool->freeBuffers);
+}
+
+mailbox_t create_mailbox(uint32_t capacity) {
+    mailbox_t res = MALLOC(sizeof(struct mailbox));
+    if (!res) return NULL;
+    void* pointers = MALLOC(capacity * sizeof(void*));
+    if (!pointers) {
+        FREE(res);
+        return NULL;
+    }
+    res->buffers = create_queue(pointers, sizeof(void*), capacity);
+    if (!res->buffers) {
+        FREE(pointers);
+        FREE(res);
+        return NULL;
+    }
+    return res;
+}
+
+void free_mailbox(mailbox_t mailbox) {
+    FREE(mailbox->buffers->storage);
+    free_queue(mailbox->buffers);
+    FREE(mailbox);
+}
+
+bool mailbox_post(mailbox_t mailbox, void* buffer, uint32_t ticks) {
+    return queue_send(mailbox->buffers, &buffer, ticks);
+}
+
+void* mailbox_fetch(mailbox_t mailbox, uint32_t ticks) {
+    void* buffer;
+    if (!queue_receive(mailbox->buffers, &buffer, ticks)) return NULL;
+    return buffer;
+}
+
+bool mailbox_post_from_isr(mailbox_t mailbox, void* buffer, bool* higherPriorityTaskWoken) {
+    return queue_send_from_isr(mailbox->buffers, &buffer, higherPriorityTaskWoken);
+}
+
+void* mailbox_fetch_from_isr(mailbox_t mailbox, bool* higherPriorityTaskWoken) {
+    void* buffer;
+    if (!queue_receive_from_isr(mailbox->buffers, &buffer, higherPriorityTaskWoken)) 
+        return NULL;
+    return buffer;
+}
@@ -0,0 +1,101 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include "queue.h"
+#include <stdlib.h>
+
+#ifndef MAILBOXES
+#define MAILBOXES
+
+/*
+ * Zero copy message passing for large buffers (e.g. sensor frames).
+ * Buffers come from a fixed pool; a sender fills one and posts the pointer,
+ * which hands the buffer over to the receiver, and the receiver returns it
+ * to the pool when done. Only the pointer is ever copied, and an empty
+ * pool blocks senders until receivers catch up.
+ */
+struct bufferPool
+{
+    queue_t freeBuffers;    // pointers to the buffers nobody owns
+    uint32_t bufferSize;
+};
+
+struct mailbox
+{
+    queue_t buffers;        // pointers to posted buffers, oldest first
+};
+
+typedef struct bufferPool *pool_t;
+typedef struct mailbox *mailbox_t;
+
+/*
+ * declares word aligned storage for count buffers of bufferSize bytes
+ */
+#define POOL_STORAGE(name, bufferSize, count) \
+    uint32_t name[(((bufferSize) + 3) / 4) * (count)]
+
+/*
+ * REQUIRES: storage holds count buffers, declared with POOL_STORAGE
+ *           count > 0
+ */
+pool_t create_pool(void* storage, uint32_t bufferSize, uint32_t count);
+
+/*
+ * Frees the pool but not its storage, which belongs to the caller
+ * REQUIRES: no thread is blocked on the pool
+ */
+void free_pool(pool_t pool);
+
+/*
+ * Takes ownership of a free buffer, blocking for up to ticks system
+ * ticks while the pool is empty. Returns NULL on timeout.
+ */
+void* pool_alloc(pool_t pool, uint32_t ticks);
+
+/*
+ * Gives a buffer back to the pool, never blocks
+ * REQUIRES: buffer came from pool_alloc on the same pool, and the caller owns it
+ */
+void pool_free(pool_t pool, void* buffer);
+
+/*
+ * non-blocking pool_alloc/pool_free for interrupt handlers,
+ * see OS_SignalFromISR
+ */
+void* pool_alloc_from_isr(pool_t pool, bool* higherPriorityTaskWoken);
+void pool_free_from_isr(pool_t pool, void* buffer, bool* higherPriorityTaskWoken);
+
+uint32_t pool_free_count(pool_t pool);
+
+/*
+ * REQUIRES: capacity > 0
+ */
+mailbox_t create_mailbox(uint32_t capacity);
+
+/*
+ * REQUIRES: no thread is blocked on the mailbox
+ */
+void free_mailbox(mailbox_t mailbox);
+
+/*
+ * Posts buffer, whose ownership passes to whoever fetches it, blocking
+ * for up to ticks system ticks while the mailbox is full.
+ * Returns true if posted, false on timeout (the caller still owns buffer).
+ */
+bool mailbox_post(mailbox_t mailbox, void* buffer, uint32_t ticks);
+
+/*
+ * Takes the oldest posted buffer, blocking for up to ticks system ticks
+ * while the mailbox is empty. Returns NULL on timeout.
+ * The caller owns the buffer and returns it with pool_free.
+ */
+void* mailbox_fetch(mailbox_t mailbox, uint32_t ticks);
+
+/*
+ * non-blocking mailbox_post/mailbox_fetch for interrupt handlers,
+ * see OS_SignalFromISR
+ */
+bool mailbox_post_from_isr(mailbox_t mailbox, void* buffer, bool* higherPriorityTaskWoken);
+void* mailbox_fetch_from_isr(mailbox_t mailbox, bool* higherPriorityTaskWoken);
+
+#endif
@@ -1,99 +1,268 @@
 #include "lists.h"
 #include "staticMalloc.h"
-#include "semaphore.h"
+#include "scheduler.h"
+#include "mutex.h"
+#include "serial.h"
 #include <stdlib.h>
 
+#if configUSE_MUTEX_PROFILING
+#define PROFILE_REPORT_MAX 8
 
-struct mutex
-{
-    list_t queue;
-    bool acquired;
-};
+static mutex_t profiledMutexes = NULL;
 
-typedef int queue_item_t;
-typedef struct mutex *mutex_t;
-int priority(queue_item_t x);
+static void profileInit(mutex_t mutex) {
+    struct mutexProfile* p = &mutex->profile;
+    p->name = "unnamed";
+    p->acquisitions = 0;
+    p->contended = 0;
+    p->timeouts = 0;
+    p->totalWaitCycles = 0;
+    p->maxWaitCycles = 0;
+    p->totalHoldCycles = 0;
+    p->maxHoldCycles = 0;
+    p->acquiredAt = 0;
+    p->next = profiledMutexes;
+    profiledMutexes = mutex;
+}
+
+static void profileRemove(mutex_t mutex) {
+    mutex_t* cur = &profiledMutexes;
+    while (*cur != NULL && *cur != mutex)
+        cur = &(*cur)->profile.next;
+    if (*cur != NULL) *cur = mutex->profile.next;
+}
+
+/*
+ * REQUIRES: the caller owns the mutex, which serializes the updates
+ */
+static void profileAcquired(mutex_t mutex, bool contended, uint32_t waitStart) {
+    struct mutexProfile* p = &mutex->profile;
+    uint32_t now = CYCLE_COUNT();
+    p->acquisitions++;
+    if (contended) {
+        uint32_t wait = now - waitStart;
+        p->contended++;
+        p->totalWaitCycles += wait;
+        if (wait > p->maxWaitCycles) p->maxWaitCycles = wait;
+    }
+    p->acquiredAt = now;
+}
+
+static void profileReleased(mutex_t mutex) {
+    struct mutexProfile* p = &mutex->profile;
+    uint32_t hold = CYCLE_COUNT() - p->acquiredAt;
+    p->totalHoldCycles += hold;
+    if (hold > p->maxHoldCycles) p->maxHoldCycles = hold;
+}
+
+static void profileTimedOut(mutex_t mutex) {
+    DISABLE_INTERRUPTS();
+    mutex->profile.timeouts++;
+    ENABLE_INTERRUPTS();
+}
+#else
+#define profileInit(mutex)
+#define profileRemove(mutex)
+#define profileAcquired(mutex, contended, waitStart)
+#define profileReleased(mutex)
+#define profileTimedOut(mutex)
+#endif
 
-semaphore_t queue_mutex = 1;
-list_t add_by_priority(list_t Queue, void *data);
-queue_item_t queue_item(int id, int priority);
-int id(queue_item_t x);
+#if configUSE_DEADLOCK_DETECTION
+// longest owner -> blocked on chain that is followed
+#define DEADLOCK_MAX_CHAIN 16
+
+/*
+ * writes the cycle as the thread ids along it, starting and ending
+ * with the running thread
+ */
+static void reportDeadlock(mutex_t mutex) {
+    SerialWrite("deadlock detected: thread ");
+    SerialWriteUnsigned(pxCurrentTCB->uxThreadId);
+    for (TCB_t* owner = mutex->owner; owner != pxCurrentTCB;
+         owner = owner->pxBlockedOnMutex->owner) {
+        SerialWrite(" -> ");
+        SerialWriteUnsigned(owner->uxThreadId);
+    }
+    SerialWrite(" -> ");
+    SerialWriteUnsigned(pxCurrentTCB->uxThreadId);
+    SerialWriteLine("");
+}
+
+/*
+ * follows the wait-for graph from mutex: its owner, the mutex that owner
+ * is blocked on, that mutex's owner and so on. If the chain leads back to
+ * the running thread, blocking on mutex would close a cycle.
+ * REQUIRES: interrupts are disabled
+ */
+static bool detectDeadlock(mutex_t mutex) {
+    TCB_t* owner = mutex->owner;
+    for (int i = 0; owner != NULL && i < DEADLOCK_MAX_CHAIN; i++) {
+        if (owner == pxCurrentTCB) {
+            reportDeadlock(mutex);
+            return true;
+        }
+        if (owner->pxBlockedOnMutex == NULL) return false;
+        owner = owner->pxBlockedOnMutex->owner;
+    }
+    return false;
+}
+#endif
 
 mutex_t create_mutex() {
     mutex_t res = MALLOC(sizeof(struct mutex));
     if (!res) return NULL;
-    res->queue = create_list();
+    res->queue = NULL;
     res->acquired = false;
+    res->recursive = false;
+    res->owner = NULL;
+    res->nesting = 0;
+    profileInit(res);
 	return res;
 }
 
+mutex_t create_recursive_mutex() {
+    mutex_t res = create_mutex();
+    if (!res) return NULL;
+    res->recursive = true;
+    return res;
+}
+
+/*
+ * REQUIRES: no thread is blocked on the mutex
+ * (the wait list nodes belong to the waiting TCBs)
+ */
 void free_mutex(mutex_t mutex) {
-    list_t Q = mutex->queue;
-    while (Q)
-        Q = delete_node(Q);
+    profileRemove(mutex);
     FREE(mutex);
 }
 
 void acquire_mutex(mutex_t mutex, int id, int priority) {
-    queue_item_t data = queue_item(id, priority);
-    OS_WaitNaive(queue_mutex);
-    mutex->queue = add_by_priority(mutex->queue, data);
-    OS_SignalNaive(queue_mutex);
-	
-	OS_WaitNaive(queue_mutex);
-    while (mutex->acquired == true || 
-		mutex->queue->data != data) {
-		OS_SignalNaive(queue_mutex);
-		__asm("NOP");		
-		__asm("NOP");
-		__asm("NOP");
-		OS_WaitNaive(queue_mutex);	
-	}
-	mutex->acquired = true;
-	mutex->queue = delete_node(mutex->queue);
-	OS_SignalNaive(queue_mutex);
+    acquire_mutex_timeout(mutex, id, priority, OS_WAIT_FOREVER);
 }
 
-void release_mutex(mutex_t mutex, int id, int priority) {
-    mutex->acquired = false;
-}
+bool acquire_mutex_timeout(mutex_t mutex, int id, int priority, uint32_t ticks) {
+    // kept in the signature for existing callers, pxCurrentTCB is what
+    // gets queued, at its own priority
+    (void)id;
+    (void)priority;
+    // only the owner can see itself in owner, so no lock is needed here
+    if (mutex->recursive && mutex->owner != NULL && mutex->owner == pxCurrentTCB) {
+        mutex->nesting++;
+        return true;
+    }
 
-list_t add_by_priority(list_t lst, void *data) {
-list_t node =  MALLOC(sizeof(list_node));
-    if (!node) return NULL;
-    node->data = data;
-    list_t current_node = lst;
-    //special case: adding to an empty list: add in front of dummy node
-    if (!(current_node->next)) {
-        node->next = lst;
-        node->prev = NULL;
-        current_node->prev = node;
-        return node;
+    DISABLE_INTERRUPTS();
+    if (!mutex->acquired) {
+        mutex->acquired = true;
+        mutex->owner = pxCurrentTCB;
+        mutex->nesting = 1;
+        ENABLE_INTERRUPTS();
+        profileAcquired(mutex, false, 0);
+        return true;
+    }
+    if (ticks == 0) {
+        ENABLE_INTERRUPTS();
+        return false;
     }
-    //loop invariant: current_node->next is never null
-    while (current_node->next->next) {
-        current_node = current_node->next;
+#if configUSE_MUTEX_PROFILING
+    uint32_t waitStart = CYCLE_COUNT();
+#endif
+#if configUSE_DEADLOCK_DETECTION
+    // a timed wait could only end in a timeout, so give up right away
+    if (detectDeadlock(mutex) && ticks != OS_WAIT_FOREVER) {
+        ENABLE_INTERRUPTS();
+        profileTimedOut(mutex);
+        return false;
     }
-    //current node is the node before the dummy node
-	while (current_node != NULL) {
-		if (priority((queue_item_t)(current_node->data)) <= priority(data)) {
-			add_as_next(current_node, data);
-			return lst;
-		}
-		current_node = current_node->prev;
-	}
-	return add_to_front(lst, data);
+    pxCurrentTCB->pxBlockedOnMutex = mutex;
+#endif
+    // sleep on the mutex and on the delayed list, the switch happens here
+    OS_blockCurrentTask(&mutex->queue, ticks);
+    ENABLE_INTERRUPTS();
+
+    // release_mutex hands the mutex over before waking us up, so if we
+    // are not the owner, the timeout woke us
+    if (mutex->owner != pxCurrentTCB) {
+        profileTimedOut(mutex);
+        return false;
+    }
+    profileAcquired(mutex, true, waitStart);
+    return true;
+}
+
+void release_mutex(mutex_t mutex, int id, int priority) {
+    // kept in the signature for existing callers, the owner is in mutex
+    (void)id;
+    (void)priority;
+    if (mutex->recursive && --(mutex->nesting) > 0)
+        return;
+
+    DISABLE_INTERRUPTS();
+    bool switchNeeded = release_mutex_locked(mutex);
+    ENABLE_INTERRUPTS();
+    if (switchNeeded) OS_yield();
 }
 
-int queue_item(int id, int priority) {
-    return (id<<16) + priority;
+bool release_mutex_locked(mutex_t mutex) {
+    profileReleased(mutex);
+    TCB_t* next = OS_waitListHead(mutex->queue);
+    if (next != NULL) {
+        mutex->owner = next;
+        mutex->nesting = 1;
+        return OS_unblockTaskFromISR(next);
+    }
+    mutex->owner = NULL;
+    mutex->nesting = 0;
+    mutex->acquired = false;
+    return false;
 }
 
-int priority(queue_item_t x) {
-    return x & 0xFFFF;
+#if configUSE_MUTEX_PROFILING
+void mutex_set_name(mutex_t mutex, const char* name) {
+    mutex->profile.name = name;
 }
 
-int id(queue_item_t x) {
-    return (x >> 16) & 0xFFFF;
+static void reportCycles(char* label, uint64_t total, uint32_t count, uint32_t max) {
+    SerialWrite(label);
+    SerialWrite(" mean/max: ");
+    SerialWriteUnsigned(count ? (uint32_t)(total / count) : 0);
+    SerialWrite("/");
+    SerialWriteUnsigned(max);
 }
 
+void mutex_profile_report(uint32_t maxLocks) {
+    mutex_t top[PROFILE_REPORT_MAX];
+    uint32_t n = 0;
+    if (maxLocks > PROFILE_REPORT_MAX) maxLocks = PROFILE_REPORT_MAX;
+
+    // insertion sort the most contended mutexes into top
+    DISABLE_INTERRUPTS();
+    for (mutex_t m = profiledMutexes; m != NULL; m = m->profile.next) {
+        uint32_t i = (n < maxLocks) ? n++ : maxLocks;
+        while (i > 0 && top[i-1]->profile.contended < m->profile.contended) {
+            if (i < maxLocks) top[i] = top[i-1];
+            i--;
+        }
+        if (i < maxLocks) top[i] = m;
+    }
+    ENABLE_INTERRUPTS();
+
+    SerialWrite("mutex contention (");
+    SerialWrite(portCYCLE_COUNT_UNIT);
+    SerialWriteLine("):");
+    for (uint32_t i = 0; i < n; i++) {
+        struct mutexProfile* p = &top[i]->profile;
+        SerialWrite((char*)p->name);
+        SerialWrite(": acquired ");
+        SerialWriteUnsigned(p->acquisitions);
+        SerialWrite(" contended ");
+        SerialWriteUnsigned(p->contended);
+        SerialWrite(" timeouts ");
+        SerialWriteUnsigned(p->timeouts);
+        reportCycles(" wait", p->totalWaitCycles, p->contended, p->maxWaitCycles);
+        reportCycles(" hold", p->totalHoldCycles, p->acquisitions, p->maxHoldCycles);
+        SerialWriteLine("");
+    }
+}
+#endif
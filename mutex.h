@@ -1,21 +1,99 @@
 #include "lists.h"
 #include "staticMalloc.h"
+#include "scheduler.h"
+#include "OSConfig.h"
 #include <stdlib.h>
 
 #ifndef MUTEXES
 #define MUTEXES
+
+#if configUSE_MUTEX_PROFILING
+/*
+ * contention statistics, times are in CYCLE_COUNT units (CPU cycles from
+ * the DWT cycle counter on the board, see portCYCLE_COUNT_UNIT)
+ */
+struct mutexProfile
+{
+    const char* name;
+    uint32_t acquisitions;
+    uint32_t contended;         // acquisitions that had to block
+    uint32_t timeouts;          // timed acquisitions that gave up
+    uint64_t totalWaitCycles;
+    uint32_t maxWaitCycles;
+    uint64_t totalHoldCycles;
+    uint32_t maxHoldCycles;
+    uint32_t acquiredAt;        // cycle count when the current owner got the mutex
+    struct mutex* next;         // every profiled mutex, for mutex_profile_report
+};
+#endif
+
 struct mutex
 {
-    list_t queue;
+    list_t queue;       // threads blocked on the mutex, highest priority first
     bool acquired;
+    bool recursive;     // owner may re-acquire, see create_recursive_mutex
+    TCB_t* owner;       // task holding the mutex, NULL when free
+    uint32_t nesting;   // times the owner has acquired without releasing
+#if configUSE_MUTEX_PROFILING
+    struct mutexProfile profile;
+#endif
 };
 
-typedef int queue_item_t;
 typedef struct mutex *mutex_t;
 
 mutex_t create_mutex();
+
+/*
+ * a recursive mutex can be acquired again by the task that already owns it.
+ * Re-entry only bumps the nesting count (no queue traffic), and the mutex is
+ * handed back once release_mutex has been called as many times as acquire_mutex
+ */
+mutex_t create_recursive_mutex();
 void free_mutex(mutex_t mutex);
+
+/*
+ * Blocks until the mutex is acquired. Waiters are served by thread
+ * priority, FIFO among equal priorities.
+ * id and priority are kept for existing callers, the running thread's
+ * TCB is what gets queued.
+ */
 void acquire_mutex(mutex_t mutex, int id, int priority);
+
+/*
+ * Same as acquire_mutex, but gives up after ticks system ticks.
+ * Returns true if the mutex was acquired, false on timeout.
+ * ticks = 0 only tries once, ticks = OS_WAIT_FOREVER never times out.
+ */
+bool acquire_mutex_timeout(mutex_t mutex, int id, int priority, uint32_t ticks);
+
+/*
+ * Releases the mutex, handing it directly to the highest priority waiter.
+ * id and priority are ignored, as in acquire_mutex.
+ */
 void release_mutex(mutex_t mutex, int id, int priority);
 
-#endif
\ No newline at end of file
+/*
+ * release_mutex for kernel objects that release a mutex and block in one
+ * step (e.g. cond_wait), ignores the recursive nesting count.
+ * Returns true if the new owner outranks the running thread.
+ * REQUIRES: interrupts are disabled, the running thread owns the mutex
+ */
+bool release_mutex_locked(mutex_t mutex);
+
+#if configUSE_MUTEX_PROFILING
+/*
+ * labels the mutex in mutex_profile_report
+ */
+void mutex_set_name(mutex_t mutex, const char* name);
+
+/*
+ * writes the statistics of the (at most maxLocks) most contended 
+ * mutexes over the serial port, most contended first
+ */
+void mutex_profile_report(uint32_t maxLocks);
+#else
+#define mutex_set_name(mutex, name)
+#define mutex_profile_report(maxLocks)
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Port layer: everything the kernel needs from the target it runs on.
+ * Each port lives in port/<target>/, a portmacro.h for the inline parts
+ * and a port.c for the rest, and the build puts that directory on the
+ * include path. port/ARM_CM4F is the TM4C123 (Cortex-M4F) port the Keil
+ * project builds, port/POSIX the host simulation.
+ *
+ * portmacro.h provides:
+ *   DISABLE_INTERRUPTS(), ENABLE_INTERRUPTS()
+ *       critical section for threads, masks every interrupt that may call
+ *       the kernel (not nested, ENABLE_INTERRUPTS unmasks all of them)
+ *   DISABLE_INTERRUPTS_FROM_ISR(), ENABLE_INTERRUPTS_FROM_ISR(previous)
+ *       the same for handlers, restoring the mask they found
+ *   __load_exclusive, __store_exclusive, __clear_exclusive
+ *       read-modify-write that fails (store returns non-zero) if anything
+ *       else ran in between
+ *   DATA_MEMORY_BARRIER()
+ *   portYIELD()
+ *       pends a context switch, which happens once interrupts are enabled
+ *   portIDLE()
+ *       what the idle thread does each time around its loop
+ *   CYCLE_COUNT(), portSETUP_CYCLE_COUNTER(), portCYCLE_COUNT_UNIT
+ *       free running 32 bit cycle counter, starting it, and the unit it
+ *       counts in as reports print it (not every port counts CPU cycles)
+ *   portCOUNT_LEADING_ZEROS(value)
+ *       optional, a single instruction bit scan (CLZ) of a non-zero
+ *       word; without it the scheduler searches the ready lists in turn
+ *   portTEST_IRQHandler, portSETUP_TEST_INTERRUPT(), portTRIGGER_TEST_INTERRUPT()
+ *       a spare interrupt tests and benchmarks can raise from software
+ */
+#include <stdint.h>
+#include "portmacro.h"
+
+#ifndef PORT_H
+#define PORT_H
+
+/*
+ * Builds the initial context of a thread that starts in program, on the
+ * stack that ends at topOfStack. Returns what OS_spawnThread keeps in the
+ * TCB's pxStack, which the port's context switch restores from.
+ */
+uint32_t* portInitialiseStack(uint32_t* topOfStack, void (*program)(void));
+
+/*
+ * Sets the tick interrupt up at configTICK_RATE_HZ without starting it
+ */
+void portSetupTimerInterrupt(void);
+
+/*
+ * Starts the tick and runs pxCurrentTCB, never returns
+ * REQUIRES: kernel interrupts are disabled
+ */
+void portStartScheduler(void);
+
+#endif /* PORT_H */
@@ -0,0 +1,197 @@
+/*
+ * Cortex-M4(F) port, for the TM4C123 boards the Keil project targets:
+ * the initial thread frame, the SysTick tick, and the PendSV context
+ * switch with threads on the process stack. See port.h.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "15348.h"
+#include "OSConfig.h"
+#include "serial.h"
+#include "scheduler.h"
+#include "port.h"
+
+#define OS_SystickHandler SysTick_Handler
+#define OS_PendSVHandler PendSV_Handler
+#define OS_SVCHandler SVC_Handler
+#define INITIAL_XPSR					( 0x01000000 )
+// return to thread mode on the process stack
+#define INITIAL_EXC_RETURN				( 0xfffffffd )
+
+// floating point context control, see the Cortex-M4 generic user guide
+#define FPCCR_R			(*((volatile uint32_t *)0xE000EF34))
+#define FPCCR_ASPEN		(0x80000000)	// set CONTROL.FPCA on the first FPU instruction
+#define FPCCR_LSPEN		(0x40000000)	// lazy stacking of S0-S15 on exception entry
+
+#if configUSE_FPU
+// only threads whose frame says they used the FPU (EXC_RETURN bit 4 clear)
+// save and restore S16-S31, the hardware stacks S0-S15 lazily
+#define PENDSV_SAVE_FPU		"	tst lr, #0x10						\n"	\
+							"	it eq								\n"	\
+							"	vstmdbeq r0!, {s16-s31}				\n"
+#define PENDSV_RESTORE_FPU	"	tst lr, #0x10						\n"	\
+							"	it eq								\n"	\
+							"	vldmiaeq r0!, {s16-s31}				\n"
+#else
+#define PENDSV_SAVE_FPU		""
+#define PENDSV_RESTORE_FPU	""
+#endif
+
+/*
+ * The initial frame is what PendSV expects to find on a stack it switches
+ * to: an exception frame that returns into program, below it EXC_RETURN
+ * and R11..R4. The register numbers are only there for debugging.
+ * REQUIRES: topOfStack is 8 byte aligned
+ */
+uint32_t* portInitialiseStack(uint32_t* topOfStack, void (*program)(void)) {
+	uint32_t* sp = topOfStack;
+	// exception frame, popped by the hardware
+	*(--sp) = INITIAL_XPSR;
+	*(--sp) = (uint32_t)program;		// PC
+	*(--sp) = INITIAL_EXC_RETURN;		// LR
+	*(--sp) = 12;						// R12
+	*(--sp) = 3;						// R3
+	*(--sp) = 2;						// R2
+	*(--sp) = 1;						// R1
+	*(--sp) = 0;						// R0
+	// {R4-R11, R14}, popped by PendSV
+	*(--sp) = INITIAL_EXC_RETURN;		// R14
+	for (uint32_t reg = 11; reg >= 4; reg--)
+		*(--sp) = reg;
+	return sp;
+}
+
+void portSetupTimerInterrupt(void) {
+	SerialWrite("Setting up systick timer..\n");
+	// Disable until configuration is done
+	NVIC_ST_CTRL_R = 0;
+    NVIC_ST_CURRENT_R = 0;
+    
+	NVIC_ST_RELOAD_R = ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) - 1UL;
+	
+	// PendSV and SysTick run at the lowest priority so that they are masked
+	// by DISABLE_INTERRUPTS and never preempt another interrupt
+	NVIC_SYS_PRI3_R |= 0xE0E00000;
+	// the counter is started by portStartScheduler
+}
+
+/*
+ * threads that never touch the FPU keep the basic exception frame, and
+ * those that do only pay for S0-S15 when an interrupt actually uses it too
+ */
+static void setupFPU(void) {
+#if configUSE_FPU
+	NVIC_CPAC_R |= NVIC_CPAC_CP10_FULL | NVIC_CPAC_CP11_FULL;
+	FPCCR_R |= FPCCR_ASPEN | FPCCR_LSPEN;
+	__asm("DSB			\n");
+	__asm("ISB			\n");
+#endif
+}
+
+/*
+ * starts the tick and switches to pxCurrentTCB through SVC, which also
+ * unmasks the kernel interrupts. CONTROL is cleared first: if main used
+ * the FPU, FPCA is still set and the SVC would stack an extended frame
+ * (and leave lazy FP state pointing at it) on the main stack that the
+ * SVC handler discards.
+ */
+void portStartScheduler(void) {
+	setupFPU();
+	NVIC_ST_CTRL_R = 0x00000007;
+	__asm volatile(
+	"	mov r0, #0							\n"
+	"	msr control, r0						\n"
+	"	isb									\n"
+	"	svc 0								\n"
+	::: "r0", "memory"
+	);
+}
+
+/**
+ * Systick handler for the device.
+ * In an effort to replicate freeRTOS's implementation, 
+ * The systick handler simply pends a pendSV interrupt
+ * which is the lowest priority interrupt that can also
+ * be pended on demand. The pendSV handler is what handles
+ * the context switch. This allows us to easily pend a thread
+ * yield on demand, and also lets our context switch only happen
+ * when all interrupts are done executing
+ */
+void OS_SystickHandler(void) {
+	// SerialWrite("Systick timer hit\n");
+	// wake up any thread whose delay or timeout has expired
+	uint32_t previous = DISABLE_INTERRUPTS_FROM_ISR();
+	OS_tickIncrement();
+	ENABLE_INTERRUPTS_FROM_ISR(previous);
+	
+	// PendSV will only run when all current 
+	portYIELD();
+}
+
+/*
+ * The context switch. Threads run on the process stack (PSP) while this 
+ * and every other handler runs on the main stack (MSP), so a thread's
+ * stack only holds its own frames plus the two saved contexts, never 
+ * nested interrupts.
+ * PendSV runs at the lowest priority, so it only starts once every other
+ * handler is done, with the outgoing thread's exception frame on top of
+ * the PSP. It saves {R4-R11, LR} below that frame, stores the new PSP in
+ * pxCurrentTCB->pxStack (the first TCB field), has the scheduler pick the
+ * next TCB (returned in R0) and unwinds that thread's stack the same way.
+ * Threads that used the FPU also get S16-S31 saved, see PENDSV_SAVE_FPU.
+ * Naked, so there is no compiler prologue to undo and nothing goes 
+ * through globals. Only kernel interrupts are masked while it runs.
+ */
+__attribute__((naked)) void OS_PendSVHandler(void) {
+	__asm volatile(
+	"	mov r0, %0							\n"
+	"	msr basepri, r0						\n"
+	"	ldr r3, pxCurrentTCBConst			\n"
+	"	ldr r1, [r3]						\n"
+	"	mrs r0, psp							\n"
+	PENDSV_SAVE_FPU
+	"	stmdb r0!, {r4-r11, lr}				\n"
+	"	str r0, [r1]						\n"
+	"	bl OS_switchToNextTask				\n"
+	"	ldr r3, pxCurrentTCBConst			\n"
+	"	str r0, [r3]						\n"
+	"	ldr r0, [r0]						\n"
+	"	ldmia r0!, {r4-r11, lr}				\n"
+	PENDSV_RESTORE_FPU
+	"	msr psp, r0							\n"
+	"	mov r0, #0							\n"
+	"	msr basepri, r0						\n"
+	"	bx lr								\n"
+	"	.align 4							\n"
+	"pxCurrentTCBConst: .word pxCurrentTCB	\n"
+	:: "i" (MAX_SYSCALL_INTERRUPT_PRIORITY << 5)
+	);
+}
+
+/*
+ * First thread launch, from the SVC in portStartScheduler. Resets the main
+ * stack to its initial top (the first vector table entry), since main 
+ * never runs again, then returns into pxCurrentTCB's initial frame on the
+ * process stack, the same way PendSV returns into a thread, and with
+ * kernel interrupts enabled.
+ */
+__attribute__((naked)) void OS_SVCHandler(void) {
+	__asm volatile(
+	"	ldr r0, vectorTableConst			\n"
+	"	ldr r0, [r0]						\n"
+	"	ldr r0, [r0]						\n"
+	"	msr msp, r0							\n"
+	"	ldr r3, pxCurrentTCBStartConst		\n"
+	"	ldr r1, [r3]						\n"
+	"	ldr r0, [r1]						\n"
+	"	ldmia r0!, {r4-r11, lr}				\n"
+	"	msr psp, r0							\n"
+	"	isb									\n"
+	"	mov r0, #0							\n"
+	"	msr basepri, r0						\n"
+	"	bx lr								\n"
+	"	.align 4							\n"
+	"vectorTableConst: .word 0xE000ED08		\n"
+	"pxCurrentTCBStartConst: .word pxCurrentTCB	\n"
+	);
+}
@@ -0,0 +1,139 @@
+/*
+ * Cortex-M4(F) port: critical sections, exclusive access, barriers,
+ * yielding and the cycle counter, for the TM4C123 boards the Keil project
+ * targets. The kernel only uses these through port.h.
+ */
+#include <stdint.h>
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+// other Cortex-M4 boards name a header that provides their own
+// CYCLE_COUNT and portSETUP_CYCLE_COUNTER, e.g. port/QEMU_MPS2_AN386
+#ifdef portBOARD_HEADER
+#include portBOARD_HEADER
+#endif
+
+// handlers at this priority or below (numerically greater or equal) 
+// are masked by DISABLE_INTERRUPTS and may call the kernel
+#define MAX_SYSCALL_INTERRUPT_PRIORITY (1)
+
+/**
+ * This sets the basepri register to have the priority
+ * setting, usually called with either 0 (all exceptions are unmasked)
+ * or 1, all exceptions are masked. 
+ * https://www.ti.com/lit/ds/spms376e/spms376e.pdf?ts=1646645911650&ref_url=https%253A%252F%252Fwww.ti.com%252Ftool%252FEK-TM4C123GXL
+ * consult page 87 of the TI datasheet above for options.
+ *
+ */
+static inline void __set_BASEPRI(uint32_t priority) {
+	priority = (priority << 5);
+	__asm("MSR basepri, %[priority]\t\n" :: [priority] "r" (priority));
+}
+
+#define DISABLE_INTERRUPTS()     \
+{								 \
+	__set_BASEPRI( MAX_SYSCALL_INTERRUPT_PRIORITY );   			 \
+	__asm("DSB			\n");	 \
+	__asm("ISB			\n");	 \
+}	
+
+#define ENABLE_INTERRUPTS()			__set_BASEPRI(0)
+
+static inline uint32_t __get_BASEPRI(void) {
+	uint32_t priority;
+	__asm volatile("MRS %[priority], basepri\t\n" : [priority] "=r" (priority));
+	return (priority >> 5);
+}
+
+/*
+ * Critical sections for interrupt handlers, which may have interrupted
+ * another handler's critical section and so have to restore the mask 
+ * they found instead of clearing it.
+ * Only handlers at or below MAX_SYSCALL_INTERRUPT_PRIORITY (numerically
+ * greater or equal) may call the kernel.
+ */
+static inline uint32_t DISABLE_INTERRUPTS_FROM_ISR(void) {
+	uint32_t previous = __get_BASEPRI();
+	DISABLE_INTERRUPTS();
+	return previous;
+}
+
+#define ENABLE_INTERRUPTS_FROM_ISR(previous)	__set_BASEPRI(previous)
+
+/*
+ * Exclusive access: __store_exclusive only writes (and returns 0) if nothing
+ * else stored to the address since the matching __load_exclusive. Exception
+ * entry and return clear the monitor, so a read-modify-write that got 
+ * interrupted by a context switch or an interrupt fails and is retried.
+ */
+static inline uint32_t __load_exclusive(volatile uint32_t* addr) {
+	uint32_t value;
+	__asm volatile("LDREX %[value], [%[addr]]" : [value] "=r" (value) : [addr] "r" (addr) : "memory");
+	return value;
+}
+
+static inline uint32_t __store_exclusive(uint32_t value, volatile uint32_t* addr) {
+	uint32_t failed;
+	__asm volatile("STREX %[failed], %[value], [%[addr]]" 
+				   : [failed] "=&r" (failed) : [value] "r" (value), [addr] "r" (addr) : "memory");
+	return failed;
+}
+
+// drops a __load_exclusive that is not followed by a store
+static inline void __clear_exclusive(void) {
+	__asm volatile("CLREX" ::: "memory");
+}
+
+// orders memory accesses on either side, for lock-free producer/consumer indices
+#define DATA_MEMORY_BARRIER()	__asm volatile("DMB" ::: "memory")
+
+// pends PendSV, the barriers make it take effect right away when
+// interrupts are enabled
+#define portNVIC_INT_CTRL_R		(*((volatile uint32_t *)0xE000ED04))
+#define portNVIC_PENDSVSET		(0x10000000)
+#define portYIELD()						\
+{										\
+	portNVIC_INT_CTRL_R = portNVIC_PENDSVSET;	\
+	__asm("DSB			\n");			\
+	__asm("ISB			\n");			\
+}
+
+// sleep until the next interrupt
+#define portIDLE()				__asm("WFI")
+
+// one CLZ instruction, for the scheduler's ready bitmap
+#define portCOUNT_LEADING_ZEROS(value)	((uint32_t)__builtin_clz(value))
+
+#ifndef CYCLE_COUNT
+// DWT cycle counter, started by CycleCounterInit (timer.c)
+#define portDWT_CYCCNT_R		(*((volatile uint32_t *)0xE0001004))
+
+void CycleCounterInit(void);
+#define portSETUP_CYCLE_COUNTER()	CycleCounterInit()
+
+// cycles elapsed since CycleCounterInit, wraps around every 2^32 cycles
+#define CYCLE_COUNT()			(portDWT_CYCCNT_R)
+#endif
+
+#ifndef portCYCLE_COUNT_UNIT
+#define portCYCLE_COUNT_UNIT	"cycles"
+#endif
+
+// a spare interrupt (analog comparator 0, unused on our boards) that
+// benchmarks and tests raise from software to get into interrupt context
+#define portTEST_IRQ			25
+#define portTEST_IRQ_PRIORITY	5
+#define portTEST_IRQHandler		COMP0_Handler
+#define portNVIC_EN0_R			(*((volatile uint32_t *)0xE000E100))
+#define portNVIC_PRI6_R			(*((volatile uint32_t *)0xE000E418))
+#define portNVIC_SW_TRIG_R		(*((volatile uint32_t *)0xE000EF00))
+
+#define portSETUP_TEST_INTERRUPT()										\
+{																		\
+	portNVIC_PRI6_R = (portNVIC_PRI6_R & ~0x0000E000) | (portTEST_IRQ_PRIORITY << 13);	\
+	portNVIC_EN0_R = 1UL << portTEST_IRQ;								\
+}
+#define portTRIGGER_TEST_INTERRUPT()	(portNVIC_SW_TRIG_R = portTEST_IRQ)
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,57 @@
+/*
+ * Entry point of the POSIX simulation.
+ * Runs the stress test of the kernel (see stresstest.h), with
+ * RUN_BENCHMARKS defined the benchmark it names (see benchmarks.h), or
+ * with RUN_TESTS defined the tests of the primitives (see
+ * primitivetests.h), for the number of ticks given as the first argument
+ * and exits, with status 1 if the stress test or a test failed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "scheduler.h"
+#include "staticMalloc.h"
+#include "serial.h"
+#include "benchmarks.h"
+#include "stresstest.h"
+#include "primitivetests.h"
+
+#define HEAP_SIZE (1 << 20)
+#define DEFAULT_RUN_TICKS (2000)
+#define CONTROLLER_TID (200)
+#define CONTROLLER_STACK_SIZE (256)
+
+char sparemem[HEAP_SIZE];
+static uint32_t runTicks = DEFAULT_RUN_TICKS;
+
+static void controller(void) {
+	OS_Delay(runTicks);
+	DISABLE_INTERRUPTS();
+#if defined(RUN_BENCHMARKS)
+	exit(0);
+#elif defined(RUN_TESTS)
+	exit(TESTS_report() ? 0 : 1);
+#else
+	exit(STRESS_report() ? 0 : 1);
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1) runTicks = strtoul(argv[1], NULL, 10);
+	simInit();
+	SetupSerial();
+	initMalloc(sparemem, HEAP_SIZE);
+	initReadyLists();
+
+	DISABLE_INTERRUPTS();
+	OS_spawnThread(&controller, CONTROLLER_TID, CONTROLLER_STACK_SIZE, 0);
+#if defined(RUN_BENCHMARKS)
+	RUN_BENCHMARKS();
+#elif defined(RUN_TESTS)
+	TESTS_start();
+#else
+	STRESS_start();
+#endif
+	OS_startScheduler();
+	return 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * POSIX simulation port
+ *
+ * Every thread of the kernel runs on a host thread, but only the one in
+ * pxCurrentTCB is ever let through its gate, so the scheduler, the lists
+ * and every synchronization primitive run exactly as on the board.
+ * - SIGALRM is SysTick: a setitimer at configTICK_RATE_HZ, handled by
+ *   whichever thread is running, which calls OS_tickIncrement and switches.
+ * - PendSV is a deferred switch: portYIELD with interrupts disabled only
+ *   pends it, and it happens as soon as they are enabled again.
+ * - A switch posts the next thread's gate, then waits on its own.
+ * Only the running thread ever has the signals unblocked, and only
+ * outside critical sections, so handlers never nest or run concurrently.
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "scheduler.h"
+#include "port.h"
+
+/*
+ * host side of a kernel thread, kept in its TCB in place of a saved SP
+ */
+struct simThread {
+	pthread_t thread;
+	sem_t gate;					// posted when the thread is switched in
+	void (*program)(void);
+};
+
+#define SIM_THREAD(tcb)		((struct simThread*)(tcb)->pxStack)
+
+__thread uint32_t simExclusiveValue;
+// host side of the kernel thread this host thread runs
+static __thread struct simThread* hostSelf = NULL;
+
+static sigset_t interruptSignals;
+static volatile bool interruptsMasked = true;
+static volatile bool switchPending = false;
+
+/*
+ * PendSV: hands the CPU to the thread the scheduler picks and
+ * sleeps until this one is picked again
+ * REQUIRES: interrupts are disabled
+ */
+static void switchContext(void) {
+	switchPending = false;
+	TCB_t* previous = pxCurrentTCB;
+	TCB_t* next = OS_switchToNextTask();
+	if (next == previous) return;
+	pxCurrentTCB = next;
+	sem_post(&SIM_THREAD(next)->gate);
+	while (sem_wait(&SIM_THREAD(previous)->gate) != 0) {}
+}
+
+void simDisableInterrupts(void) {
+	pthread_sigmask(SIG_BLOCK, &interruptSignals, NULL);
+	interruptsMasked = true;
+}
+
+void simEnableInterrupts(void) {
+	if (switchPending) switchContext();
+	interruptsMasked = false;
+	pthread_sigmask(SIG_UNBLOCK, &interruptSignals, NULL);
+}
+
+uint32_t simDisableInterruptsFromISR(void) {
+	uint32_t previous = interruptsMasked;
+	simDisableInterrupts();
+	return previous;
+}
+
+void simEnableInterruptsFromISR(uint32_t previous) {
+	if (!previous) simEnableInterrupts();
+}
+
+void simYield(void) {
+	switchPending = true;
+	if (!interruptsMasked) {
+		simDisableInterrupts();
+		simEnableInterrupts();
+	}
+}
+
+uint32_t simCycleCount(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+/*
+ * handlers must only ever run on the thread in pxCurrentTCB
+ */
+static void checkRunning(void) {
+	if (hostSelf == NULL || SIM_THREAD(pxCurrentTCB) != hostSelf) {
+		fprintf(stderr, "interrupt taken by a thread that is not running\n");
+		abort();
+	}
+}
+
+/*
+ * SysTick: the interrupt signals are blocked while the handler runs, and the
+ * switch it always pends happens before it returns
+ */
+static void tickHandler(int signal) {
+	(void)signal;
+	checkRunning();
+	interruptsMasked = true;
+	OS_tickIncrement();
+	switchContext();
+	interruptsMasked = false;
+}
+
+__attribute__((weak)) void simTestIRQHandler(void) {
+}
+
+static void testInterruptHandler(int signal) {
+	(void)signal;
+	checkRunning();
+	interruptsMasked = true;
+	simTestIRQHandler();
+	if (switchPending) switchContext();
+	interruptsMasked = false;
+}
+
+void simTriggerTestInterrupt(void) {
+	pthread_kill(pthread_self(), SIGUSR1);
+}
+
+static void* threadEntry(void* arg) {
+	struct simThread* self = arg;
+	hostSelf = self;
+	while (sem_wait(&self->gate) != 0) {}
+	// first switched in, like returning from PendSV into the initial frame
+	interruptsMasked = false;
+	pthread_sigmask(SIG_UNBLOCK, &interruptSignals, NULL);
+	self->program();
+	fprintf(stderr, "thread returned from its program\n");
+	abort();
+}
+
+/*
+ * Each thread runs on its host thread's stack rather than the one the
+ * kernel allocated, so topOfStack is ignored and what ends up in pxStack
+ * is the thread's struct simThread.
+ * REQUIRES: interrupts are disabled (so the new thread starts blocked)
+ */
+uint32_t* portInitialiseStack(uint32_t* topOfStack, void (*program)(void)) {
+	(void)topOfStack;
+	struct simThread* sim = malloc(sizeof(struct simThread));
+	if (sim == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	sim->program = program;
+	sem_init(&sim->gate, 0, 0);
+	// the new thread inherits the blocked interrupt signals
+	if (pthread_create(&sim->thread, NULL, &threadEntry, sim) != 0) {
+		perror("pthread_create");
+		exit(1);
+	}
+	return (uint32_t*)sim;
+}
+
+void simInit(void) {
+	sigemptyset(&interruptSignals);
+	sigaddset(&interruptSignals, SIGALRM);
+	sigaddset(&interruptSignals, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &interruptSignals, NULL);
+
+	struct sigaction action;
+	// a handler runs with every simulated interrupt blocked, also while it
+	// is parked in switchContext
+	action.sa_mask = interruptSignals;
+	action.sa_flags = SA_RESTART;
+	action.sa_handler = &testInterruptHandler;
+	sigaction(SIGUSR1, &action, NULL);
+}
+
+void portSetupTimerInterrupt(void) {
+	struct sigaction action;
+	action.sa_mask = interruptSignals;
+	action.sa_flags = SA_RESTART;
+	action.sa_handler = &tickHandler;
+	sigaction(SIGALRM, &action, NULL);
+}
+
+/*
+ * The calling (main) thread keeps the interrupt signals blocked and just
+ * sleeps from then on.
+ */
+void portStartScheduler(void) {
+	struct itimerval tick;
+	tick.it_interval.tv_sec = 0;
+	tick.it_interval.tv_usec = 1000000 / configTICK_RATE_HZ;
+	tick.it_value = tick.it_interval;
+	setitimer(ITIMER_REAL, &tick, NULL);
+
+	sem_post(&SIM_THREAD(pxCurrentTCB)->gate);
+	while (1) pause();
+}
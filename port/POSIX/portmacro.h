@@ -0,0 +1,72 @@
+/*
+ * POSIX simulation port: the same interface as the Cortex-M4 portmacro.h,
+ * for running the kernel as a Linux process (see port.c).
+ * "Interrupts" are the tick (SIGALRM) and test interrupt (SIGUSR1)
+ * signals, and disabling interrupts blocks them in the running thread.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+// installs the signal handlers, call first thing in main
+void simInit(void);
+
+void simDisableInterrupts(void);
+void simEnableInterrupts(void);
+uint32_t simDisableInterruptsFromISR(void);
+void simEnableInterruptsFromISR(uint32_t previous);
+
+// a switch pended while interrupts are disabled happens once they are
+// enabled again, just like PendSV
+#define DISABLE_INTERRUPTS()					simDisableInterrupts()
+#define ENABLE_INTERRUPTS()						simEnableInterrupts()
+#define DISABLE_INTERRUPTS_FROM_ISR()			simDisableInterruptsFromISR()
+#define ENABLE_INTERRUPTS_FROM_ISR(previous)	simEnableInterruptsFromISR(previous)
+
+/*
+ * Exclusive access as a compare and swap against the value the running
+ * thread loaded, which fails whenever another thread or handler stored
+ * something else in between, like STREX does after a context switch.
+ */
+extern __thread uint32_t simExclusiveValue;
+
+static inline uint32_t __load_exclusive(volatile uint32_t* addr) {
+	simExclusiveValue = __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+	return simExclusiveValue;
+}
+
+static inline uint32_t __store_exclusive(uint32_t value, volatile uint32_t* addr) {
+	uint32_t expected = simExclusiveValue;
+	return !__atomic_compare_exchange_n(addr, &expected, value, false,
+										__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline void __clear_exclusive(void) {
+}
+
+#define DATA_MEMORY_BARRIER()	__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+void simYield(void);
+#define portYIELD()				simYield()
+
+// the idle thread sleeps until a signal arrives
+#define portIDLE()				pause()
+
+#define portCOUNT_LEADING_ZEROS(value)	((uint32_t)__builtin_clz(value))
+
+// nanoseconds rather than cycles, from the host's monotonic clock
+uint32_t simCycleCount(void);
+#define CYCLE_COUNT()			simCycleCount()
+#define portSETUP_CYCLE_COUNTER()
+#define portCYCLE_COUNT_UNIT	"ns"
+
+// the test interrupt is SIGUSR1, delivered to the running thread
+void simTriggerTestInterrupt(void);
+#define portTEST_IRQHandler				simTestIRQHandler
+#define portSETUP_TEST_INTERRUPT()
+#define portTRIGGER_TEST_INTERRUPT()	simTriggerTestInterrupt()
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,30 @@
+/*
+ * serial.c for the POSIX simulation port, writes to stdout
+ */
+#include <stdio.h>
+#include "serial.h"
+
+void SetupSerial()
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+}
+
+void SerialWrite(char* st)
+{
+    fputs(st, stdout);
+}
+
+void SerialWriteLine(char* st)
+{
+    puts(st);
+}
+
+void SerialWriteInt(int n)
+{
+    printf("%d\n", n);
+}
+
+void SerialWriteUnsigned(unsigned int n)
+{
+    printf("%u", n);
+}
@@ -0,0 +1,34 @@
+/*
+ * MPS2 AN386 (Cortex-M4F) board, as emulated by qemu-system-arm -M mps2-an386.
+ * The Cortex-M4F port includes this as its portBOARD_HEADER. QEMU does
+ * not model the DWT, so the cycle counter is the CMSDK dual timer instead,
+ * which runs at the 25 MHz system clock in QEMU's virtual time. Its counts
+ * are timer ticks of 40 ns, not CPU cycles, and reports say so.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef BOARD_H
+#define BOARD_H
+
+// CMSDK dual timer, timer 1 free running as a 32 bit down counter
+#define boardTIMER1_LOAD_R		(*((volatile uint32_t *)0x40002000))
+#define boardTIMER1_VALUE_R		(*((volatile uint32_t *)0x40002004))
+#define boardTIMER1_CTRL_R		(*((volatile uint32_t *)0x40002008))
+#define boardTIMER_CTRL_ENABLE	(0x80)
+#define boardTIMER_CTRL_32BIT	(0x02)
+
+void boardCycleCounterInit(void);
+#define portSETUP_CYCLE_COUNTER()	boardCycleCounterInit()
+
+// inverted so that it counts up and wraps around like the DWT's
+#define CYCLE_COUNT()			(~boardTIMER1_VALUE_R)
+#define portCYCLE_COUNT_UNIT	"timer counts (40 ns)"
+
+/*
+ * Ends the emulation through semihosting: qemu-system-arm exits with
+ * status 0 if passed, 1 otherwise
+ */
+void boardExit(bool passed);
+
+#endif /* BOARD_H */
@@ -0,0 +1,52 @@
+/*
+ * Entry point of the QEMU build.
+ * Runs the stress test of the kernel (see stresstest.h), or with
+ * RUN_BENCHMARKS defined the benchmark it names (see benchmarks.h), for
+ * RUN_TICKS ticks of emulated time and ends the emulation, failing it if
+ * the stress test failed.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "scheduler.h"
+#include "staticMalloc.h"
+#include "serial.h"
+#include "benchmarks.h"
+#include "stresstest.h"
+#include "board.h"
+
+#define HEAP_SIZE (64 * 1024)
+#define CONTROLLER_TID (200)
+#define CONTROLLER_STACK_SIZE (256)
+
+#ifndef RUN_TICKS
+#define RUN_TICKS (2000)
+#endif
+
+char sparemem[HEAP_SIZE];
+
+static void controller(void) {
+	OS_Delay(RUN_TICKS);
+	DISABLE_INTERRUPTS();
+#ifndef RUN_BENCHMARKS
+	boardExit(STRESS_report());
+#else
+	boardExit(true);
+#endif
+}
+
+int main(void)
+{
+	SetupSerial();
+	initMalloc(sparemem, HEAP_SIZE);
+	initReadyLists();
+
+	DISABLE_INTERRUPTS();
+	OS_spawnThread(&controller, CONTROLLER_TID, CONTROLLER_STACK_SIZE, 0);
+#ifdef RUN_BENCHMARKS
+	RUN_BENCHMARKS();
+#else
+	STRESS_start();
+#endif
+	OS_startScheduler();
+	return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * serial.c for the MPS2 AN386, on the CMSDK UART0 that QEMU connects to
+ * its first serial port
+ */
+#include <stdint.h>
+#include "serial.h"
+
+#define UART0_DATA_R		(*((volatile uint32_t *)0x40004000))
+#define UART0_STATE_R		(*((volatile uint32_t *)0x40004004))
+#define UART0_CTRL_R		(*((volatile uint32_t *)0x40004008))
+#define UART0_BAUDDIV_R		(*((volatile uint32_t *)0x40004010))
+#define UART_STATE_TXFULL	0x01
+#define UART_CTRL_TXEN		0x01
+
+static void SerialWriteChar(char c)
+{
+    while (UART0_STATE_R & UART_STATE_TXFULL);
+    UART0_DATA_R = c;
+}
+
+void SetupSerial()
+{
+    UART0_BAUDDIV_R = 16;
+    UART0_CTRL_R = UART_CTRL_TXEN;
+}
+
+void SerialWrite(char* st)
+{
+    while (*st != 0)
+        SerialWriteChar(*st++);
+}
+
+void SerialWriteLine(char* st)
+{
+    SerialWrite(st);
+    SerialWriteChar('\n');
+}
+
+void SerialWriteInt(int n)
+{
+    if (n < 0)
+    {
+        SerialWriteChar('-');
+        n = -n;
+    }
+    SerialWriteUnsigned(n);
+    SerialWriteChar('\n');
+}
+
+void SerialWriteUnsigned(unsigned int n)
+{
+    char str[11];
+    int i = 10;
+    str[i] = 0;
+    do
+    {
+        i--;
+        str[i] = '0'+n%10;
+        n = n/10;
+    } while (n>0);
+    SerialWrite(&str[i]);
+}
@@ -0,0 +1,88 @@
+/*
+ * Vector table, reset handler and the board services of board.h for the
+ * MPS2 AN386 under QEMU. The kernel's handlers come from the Cortex-M4F
+ * port (port/ARM_CM4F/port.c), the test interrupt's from benchmarks.c.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "serial.h"
+#include "portmacro.h"
+
+#define BOARD_NUM_IRQS			(32)
+
+// coprocessor access control, full access to CP10/CP11 (the FPU)
+#define CPACR_R					(*((volatile uint32_t *)0xE000ED88))
+#define CPACR_CP10_CP11_FULL	(0x00F00000)
+
+// semihosting operation and stop reasons, see the Arm semihosting spec
+#define SEMIHOSTING_SYS_EXIT				(0x18)
+#define SEMIHOSTING_APPLICATION_EXIT		(0x20026)
+#define SEMIHOSTING_RUN_TIME_ERROR			(0x20023)
+
+// from the linker script
+extern uint32_t _estack;
+extern uint32_t _sidata, _sdata, _edata, _sbss, _ebss;
+
+int main(void);
+void SVC_Handler(void);
+void PendSV_Handler(void);
+void SysTick_Handler(void);
+void portTEST_IRQHandler(void);
+
+void boardCycleCounterInit(void) {
+	boardTIMER1_CTRL_R = 0;
+	boardTIMER1_LOAD_R = 0xFFFFFFFF;
+	boardTIMER1_CTRL_R = boardTIMER_CTRL_ENABLE | boardTIMER_CTRL_32BIT;
+}
+
+void boardExit(bool passed) {
+	register uint32_t operation __asm("r0") = SEMIHOSTING_SYS_EXIT;
+	register uint32_t reason __asm("r1") = passed ? SEMIHOSTING_APPLICATION_EXIT 
+												  : SEMIHOSTING_RUN_TIME_ERROR;
+	__asm volatile("BKPT 0xAB" :: "r" (operation), "r" (reason) : "memory");
+	while (1) {}
+}
+
+/*
+ * The FPU is enabled before anything else runs, since the build uses the
+ * hard float ABI and the compiler may emit VFP instructions anywhere.
+ * Lazy stacking is set up later, by the port's portStartScheduler.
+ */
+void Reset_Handler(void) {
+	CPACR_R |= CPACR_CP10_CP11_FULL;
+	__asm volatile("DSB			\n");
+	__asm volatile("ISB			\n");
+	uint32_t* src = &_sidata;
+	uint32_t* dst;
+	for (dst = &_sdata; dst < &_edata; dst++) *dst = *src++;
+	for (dst = &_sbss; dst < &_ebss; dst++) *dst = 0;
+	main();
+	boardExit(false);
+}
+
+/*
+ * a fault fails the run right away instead of leaving it to time out
+ */
+static void faultHandler(void) {
+	SerialWriteLine("fault");
+	boardExit(false);
+}
+
+static void defaultHandler(void) {
+	SerialWriteLine("unexpected interrupt");
+	boardExit(false);
+}
+
+__attribute__((section(".isr_vector"), used))
+void (* const vectorTable[16 + BOARD_NUM_IRQS])(void) = {
+	[0] = (void (*)(void))&_estack,
+	[1] = Reset_Handler,
+	[2 ... 6] = faultHandler,			// NMI, HardFault, MemManage, BusFault, UsageFault
+	[7 ... 10] = defaultHandler,
+	[11] = SVC_Handler,
+	[12 ... 13] = defaultHandler,
+	[14] = PendSV_Handler,
+	[15] = SysTick_Handler,
+	[16 ... 16 + BOARD_NUM_IRQS - 1] = defaultHandler,
+	[16 + portTEST_IRQ] = portTEST_IRQHandler,
+};
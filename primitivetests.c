@@ -0,0 +1,525 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "serial.h"
+#include "scheduler.h"
+#include "semaphore.h"
+#include "rwlock.h"
+#include "eventgroup.h"
+#include "mutex.h"
+#include "condvar.h"
+#include "barrier.h"
+#include "mailbox.h"
+#include "streambuffer.h"
+#include "queue.h"
+#include "topic.h"
+#include "primitivetests.h"
+
+#define TESTS_STACK_SIZE 256
+#define TESTS_RUNNER_TID 300
+#define TESTS_HELPER_TID 301		// helpers are numbered on from here
+#define TESTS_RUNNER_PRIORITY 1
+#define TESTS_HELPER_PRIORITY 2
+#define TESTS_SETTLE_TICKS 2		// lets every ready helper run until it blocks
+#define TESTS_TIMEOUT_TICKS 100		// a helper still not done by then is stuck
+
+/*
+ * fails the running test, which reports the check that did not hold
+ */
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			failedCheck = #condition; \
+			return false; \
+		} \
+	} while (0)
+
+static char* failedCheck;
+static volatile uint32_t nextHelperTid = TESTS_HELPER_TID;
+static csemaphore_t helpersDone;	// signalled by every helper at its end
+static csemaphore_t parking;		// never signalled
+
+/*
+ * helpers run at a lower priority than the runner, so a new one only
+ * starts once the runner sleeps or blocks
+ */
+static void spawnHelper(void (*program)(void)) {
+	// spawning touches the ready lists
+	DISABLE_INTERRUPTS();
+	OS_spawnThread(program, nextHelperTid++, TESTS_STACK_SIZE, TESTS_HELPER_PRIORITY);
+	ENABLE_INTERRUPTS();
+}
+
+/*
+ * the last thing every helper does, threads never return
+ */
+static void finishHelper(void) {
+	OS_Signal(helpersDone);
+	OS_Wait(parking);
+}
+
+/*
+ * returns false if one of count helpers did not finish in time
+ */
+static bool joinHelpers(uint32_t count) {
+	for (uint32_t i = 0; i < count; i++)
+		if (!OS_WaitTimeout(helpersDone, TESTS_TIMEOUT_TICKS)) return false;
+	return true;
+}
+
+/*
+ * reader-writer lock
+ * three readers hold the lock at once. Then, with one reader holding it
+ * and a writer waiting, a reader that comes later has to queue behind
+ * the writer, or a stream of readers could starve it.
+ */
+static rwlock_t testLock;
+static csemaphore_t releaseRead;	// holding readers keep the lock until signalled
+static volatile uint32_t readersInside = 0;
+static volatile uint32_t turns = 0;
+static volatile uint32_t writerTurn = 0;
+static volatile uint32_t lateReaderTurn = 0;
+
+static void holdingReader(void) {
+	acquire_read(testLock);
+	readersInside++;
+	OS_Wait(releaseRead);
+	readersInside--;
+	release_read(testLock);
+	finishHelper();
+}
+
+static void waitingWriter(void) {
+	acquire_write(testLock);
+	writerTurn = ++turns;
+	release_write(testLock);
+	finishHelper();
+}
+
+static void lateReader(void) {
+	acquire_read(testLock);
+	lateReaderTurn = ++turns;
+	release_read(testLock);
+	finishHelper();
+}
+
+static bool rwlockTests(void) {
+	testLock = create_rwlock(true);
+	releaseRead = create_semaphore(0, WAIT_ORDER_FIFO);
+	for (int i = 0; i < 3; i++) spawnHelper(&holdingReader);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(readersInside == 3);
+	CHECK(!acquire_write_timeout(testLock, 0));
+	for (int i = 0; i < 3; i++) OS_Signal(releaseRead);
+	CHECK(joinHelpers(3));
+
+	spawnHelper(&holdingReader);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	spawnHelper(&waitingWriter);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	spawnHelper(&lateReader);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(readersInside == 1 && writerTurn == 0 && lateReaderTurn == 0);
+	OS_Signal(releaseRead);
+	CHECK(joinHelpers(3));
+	CHECK(writerTurn == 1 && lateReaderTurn == 2);
+	free_semaphore(releaseRead);
+	free_rwlock(testLock);
+	return true;
+}
+
+/*
+ * event groups
+ * a wait-any waiter wakes on either bit and leaves it set, a wait-all
+ * waiter sleeps through the first of its bits, wakes on the second and
+ * clears only the bits it waited for
+ */
+#define EVENT_A (1 << 0)
+#define EVENT_B (1 << 1)
+#define EVENT_OTHER (1 << 2)
+
+static eventgroup_t testGroup;
+static volatile bool eventWaitAll;
+static volatile bool eventWaitDone;
+static volatile uint32_t eventBits;
+
+static void eventWaiter(void) {
+	eventBits = event_group_wait_bits(testGroup, EVENT_A | EVENT_B, eventWaitAll,
+									  eventWaitAll, TESTS_TIMEOUT_TICKS);
+	eventWaitDone = true;
+	finishHelper();
+}
+
+static bool eventGroupTests(void) {
+	testGroup = create_event_group();
+	eventWaitAll = false;
+	eventWaitDone = false;
+	spawnHelper(&eventWaiter);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(!eventWaitDone);
+	event_group_set_bits(testGroup, EVENT_B);
+	CHECK(joinHelpers(1));
+	CHECK(eventBits == EVENT_B);
+	CHECK(event_group_get_bits(testGroup) == EVENT_B);
+
+	event_group_clear_bits(testGroup, EVENT_B);
+	event_group_set_bits(testGroup, EVENT_OTHER);
+	eventWaitAll = true;
+	eventWaitDone = false;
+	spawnHelper(&eventWaiter);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	event_group_set_bits(testGroup, EVENT_A);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(!eventWaitDone);
+	event_group_set_bits(testGroup, EVENT_B);
+	CHECK(joinHelpers(1));
+	CHECK(eventBits == (EVENT_A | EVENT_B | EVENT_OTHER));
+	CHECK(event_group_get_bits(testGroup) == EVENT_OTHER);
+	free_event_group(testGroup);
+	return true;
+}
+
+/*
+ * condition variables
+ * of three threads waiting on the condition, a signal wakes exactly one
+ * and a broadcast the other two
+ */
+static mutex_t condMutex;
+static condvar_t testCond;
+static volatile uint32_t condWoken = 0;
+
+static void condWaiter(void) {
+	uint32_t id = pxCurrentTCB->uxThreadId;
+	acquire_mutex(condMutex, id, TESTS_HELPER_PRIORITY);
+	cond_wait(testCond, condMutex);
+	condWoken++;
+	release_mutex(condMutex, id, TESTS_HELPER_PRIORITY);
+	finishHelper();
+}
+
+static bool condvarTests(void) {
+	condMutex = create_mutex();
+	testCond = create_condvar();
+	for (int i = 0; i < 3; i++) spawnHelper(&condWaiter);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(condWoken == 0);
+	cond_signal(testCond);
+	CHECK(joinHelpers(1));
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(condWoken == 1);
+	cond_broadcast(testCond);
+	CHECK(joinHelpers(2));
+	CHECK(condWoken == 3);
+	free_condvar(testCond);
+	free_mutex(condMutex);
+	return true;
+}
+
+/*
+ * barriers
+ * three parties go through the same barrier generation after generation,
+ * with a different one arriving a tick late each time. Nobody may leave
+ * a generation before everyone arrived in it, and exactly one party per
+ * generation is told it was the last.
+ */
+#define BARRIER_PARTIES 3
+#define BARRIER_GENERATIONS 5
+
+static barrier_t testBarrier;
+static volatile uint32_t generationReached[BARRIER_PARTIES];
+static volatile uint32_t lastArrivals = 0;
+static volatile uint32_t barrierViolations = 0;
+
+static void barrierParty(void) {
+	// helpers have consecutive ids
+	uint32_t party = pxCurrentTCB->uxThreadId % BARRIER_PARTIES;
+	for (uint32_t generation = 1; generation <= BARRIER_GENERATIONS; generation++) {
+		if (generation % BARRIER_PARTIES == party) OS_Delay(1);
+		generationReached[party] = generation;
+		if (barrier_wait(testBarrier)) lastArrivals++;
+		// the others are in this generation or already waiting in the next
+		for (uint32_t i = 0; i < BARRIER_PARTIES; i++)
+			if (generationReached[i] != generation && generationReached[i] != generation + 1)
+				barrierViolations++;
+	}
+	finishHelper();
+}
+
+static bool barrierTests(void) {
+	testBarrier = create_barrier(BARRIER_PARTIES);
+	for (int i = 0; i < BARRIER_PARTIES; i++) spawnHelper(&barrierParty);
+	CHECK(joinHelpers(BARRIER_PARTIES));
+	CHECK(barrierViolations == 0);
+	CHECK(lastArrivals == BARRIER_GENERATIONS);
+	free_barrier(testBarrier);
+	return true;
+}
+
+/*
+ * mailboxes
+ * a sender posting three buffers through a pool of two blocks on the
+ * third allocation until the receiver gives a buffer back
+ */
+#define MAIL_POOL_BUFFERS 2
+#define MAIL_MESSAGES 3
+
+static pool_t testPool;
+static POOL_STORAGE(testPoolStorage, sizeof(uint32_t), MAIL_POOL_BUFFERS);
+static mailbox_t testMailbox;
+static volatile uint32_t mailSent = 0;
+
+static void mailSender(void) {
+	for (uint32_t i = 0; i < MAIL_MESSAGES; i++) {
+		uint32_t* buffer = pool_alloc(testPool, TESTS_TIMEOUT_TICKS);
+		if (buffer == NULL) break;
+		*buffer = i;
+		mailbox_post(testMailbox, buffer, 0);
+		mailSent++;
+	}
+	finishHelper();
+}
+
+static bool mailboxTests(void) {
+	testPool = create_pool(testPoolStorage, sizeof(uint32_t), MAIL_POOL_BUFFERS);
+	testMailbox = create_mailbox(MAIL_MESSAGES);
+	spawnHelper(&mailSender);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(mailSent == MAIL_POOL_BUFFERS);
+	CHECK(pool_free_count(testPool) == 0);
+	CHECK(pool_alloc(testPool, 0) == NULL);
+
+	uint32_t* buffer = mailbox_fetch(testMailbox, 0);
+	CHECK(buffer != NULL && *buffer == 0);
+	pool_free(testPool, buffer);
+	CHECK(joinHelpers(1));
+	CHECK(mailSent == MAIL_MESSAGES);
+	for (uint32_t i = 1; i < MAIL_MESSAGES; i++) {
+		buffer = mailbox_fetch(testMailbox, 0);
+		CHECK(buffer != NULL && *buffer == i);
+		pool_free(testPool, buffer);
+	}
+	CHECK(pool_free_count(testPool) == MAIL_POOL_BUFFERS);
+	free_mailbox(testMailbox);
+	free_pool(testPool);
+	return true;
+}
+
+/*
+ * stream buffers
+ * a reader blocked on a stream with a trigger level of four bytes sleeps
+ * through a write of three, and wakes to read all five once two more
+ * arrive
+ */
+#define STREAM_SIZE 16
+#define STREAM_TRIGGER 4
+
+static streambuffer_t testStream;
+static uint8_t testStreamStorage[STREAM_SIZE];
+static uint8_t streamReceived[STREAM_SIZE];
+static volatile uint32_t streamRead = 0;
+static volatile bool streamReadDone = false;
+
+static void streamReader(void) {
+	streamRead = stream_buffer_receive(testStream, streamReceived, STREAM_SIZE,
+									   TESTS_TIMEOUT_TICKS);
+	streamReadDone = true;
+	finishHelper();
+}
+
+static bool streamBufferTests(void) {
+	const uint8_t bytes[] = { 1, 2, 3, 4, 5 };
+	testStream = create_stream_buffer(testStreamStorage, STREAM_SIZE, STREAM_TRIGGER);
+	spawnHelper(&streamReader);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(stream_buffer_send(testStream, bytes, 3, 0) == 3);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(!streamReadDone);
+	CHECK(stream_buffer_send(testStream, bytes + 3, 2, 0) == 2);
+	CHECK(joinHelpers(1));
+	CHECK(streamRead == sizeof(bytes));
+	for (uint32_t i = 0; i < sizeof(bytes); i++)
+		CHECK(streamReceived[i] == bytes[i]);
+	CHECK(stream_buffer_available(testStream) == 0);
+	free_stream_buffer(testStream);
+	return true;
+}
+
+/*
+ * queue sets
+ * a thread selecting on a set of two queues and a semaphore gets back
+ * whichever member was given an item, each time a different one
+ */
+#define SET_QUEUE_LENGTH 2
+#define SET_SELECTS 3
+
+static queueset_t testSet;
+static queue_t setQueueA;
+static queue_t setQueueB;
+static QUEUE_STORAGE(setQueueAStorage, sizeof(uint32_t), SET_QUEUE_LENGTH);
+static QUEUE_STORAGE(setQueueBStorage, sizeof(uint32_t), SET_QUEUE_LENGTH);
+static csemaphore_t setSemaphore;
+static void* volatile selected[SET_SELECTS];
+static volatile uint32_t selectedItems[SET_SELECTS];
+static volatile uint32_t selects = 0;
+
+static void setSelector(void) {
+	for (uint32_t i = 0; i < SET_SELECTS; i++) {
+		void* member = queue_set_select(testSet, TESTS_TIMEOUT_TICKS);
+		uint32_t item = 0;
+		if (member == setSemaphore) item = OS_WaitTimeout(setSemaphore, 0);
+		else if (member != NULL) queue_receive(member, &item, 0);
+		selected[i] = member;
+		selectedItems[i] = item;
+		selects++;
+	}
+	finishHelper();
+}
+
+static bool queueSetTests(void) {
+	uint32_t item;
+	testSet = create_queue_set(2 * SET_QUEUE_LENGTH + 1);
+	setQueueA = create_queue(setQueueAStorage, sizeof(uint32_t), SET_QUEUE_LENGTH);
+	setQueueB = create_queue(setQueueBStorage, sizeof(uint32_t), SET_QUEUE_LENGTH);
+	setSemaphore = create_semaphore(0, WAIT_ORDER_PRIORITY);
+	queue_set_add_queue(testSet, setQueueA);
+	queue_set_add_queue(testSet, setQueueB);
+	queue_set_add_semaphore(testSet, setSemaphore);
+	spawnHelper(&setSelector);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(selects == 0);
+
+	item = 20;
+	queue_send(setQueueB, &item, 0);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(selects == 1 && selected[0] == setQueueB && selectedItems[0] == 20);
+	OS_Signal(setSemaphore);
+	OS_Delay(TESTS_SETTLE_TICKS);
+	CHECK(selects == 2 && selected[1] == setSemaphore && selectedItems[1] == 1);
+	item = 10;
+	queue_send(setQueueA, &item, 0);
+	CHECK(joinHelpers(1));
+	CHECK(selected[2] == setQueueA && selectedItems[2] == 10);
+	free_semaphore(setSemaphore);
+	free_queue(setQueueB);
+	free_queue(setQueueA);
+	free_queue_set(testSet);
+	return true;
+}
+
+/*
+ * topics
+ * a publisher and a subscriber at the same priority share the CPU tick by
+ * tick, so publishes keep landing in the middle of reads. Every value read
+ * must be whole (all its words from the same publish) and the one its
+ * version says, however many publishes went by.
+ */
+#define TOPIC_WORDS 64
+#define TOPIC_TEST_TICKS 50
+
+struct topicTestValue {
+	uint32_t words[TOPIC_WORDS];
+};
+
+TOPIC(testTopic, sizeof(struct topicTestValue));
+SUBSCRIBER(testSubscriber, testTopic);
+static volatile bool topicStop = false;
+static volatile uint32_t topicReads = 0;
+static volatile uint32_t topicSkips = 0;	// reads that missed publishes
+static volatile uint32_t topicTorn = 0;
+
+static void topicPublisher(void) {
+	struct topicTestValue value;
+	for (uint32_t n = 1; !topicStop; n++) {
+		for (uint32_t i = 0; i < TOPIC_WORDS; i++) value.words[i] = n;
+		topic_publish(&testTopic, &value);
+	}
+	finishHelper();
+}
+
+static void topicReader(void) {
+	struct topicTestValue value;
+	uint32_t last = 0;
+	uint32_t start = xTickCount;
+	while (xTickCount - start < TOPIC_TEST_TICKS) {
+		if (!topic_read(&testSubscriber, &value)) continue;
+		// publish n is version n
+		if (value.words[0] != testSubscriber.seen || value.words[0] < last) topicTorn++;
+		for (uint32_t i = 1; i < TOPIC_WORDS; i++)
+			if (value.words[i] != value.words[0]) topicTorn++;
+		if (value.words[0] > last + 1) topicSkips++;
+		last = value.words[0];
+		topicReads++;
+	}
+	topicStop = true;
+	finishHelper();
+}
+
+static bool topicTests(void) {
+	spawnHelper(&topicPublisher);
+	spawnHelper(&topicReader);
+	CHECK(joinHelpers(2));
+	CHECK(topicReads > 0 && topicSkips > 0);
+	CHECK(topicTorn == 0);
+	return true;
+}
+
+/*
+ * run in this order, one at a time
+ */
+static const struct {
+	char* name;
+	bool (*run)(void);
+} tests[] = {
+	{ "rwlock", &rwlockTests },
+	{ "event group", &eventGroupTests },
+	{ "condition variable", &condvarTests },
+	{ "barrier", &barrierTests },
+	{ "mailbox", &mailboxTests },
+	{ "stream buffer", &streamBufferTests },
+	{ "queue set", &queueSetTests },
+	{ "topic", &topicTests },
+};
+
+#define TEST_COUNT (sizeof(tests) / sizeof(tests[0]))
+
+typedef enum {
+	TEST_NOT_RUN = 0,
+	TEST_PASSED,
+	TEST_FAILED
+} testResult_t;
+
+static volatile testResult_t results[TEST_COUNT];
+static char* failures[TEST_COUNT];
+
+static void testRunner(void) {
+	for (uint32_t i = 0; i < TEST_COUNT; i++) {
+		failedCheck = NULL;
+		results[i] = tests[i].run() ? TEST_PASSED : TEST_FAILED;
+		failures[i] = failedCheck;
+	}
+	OS_Wait(parking);
+}
+
+void TESTS_start(void) {
+	helpersDone = create_semaphore(0, WAIT_ORDER_FIFO);
+	parking = create_semaphore(0, WAIT_ORDER_FIFO);
+	OS_spawnThread(&testRunner, TESTS_RUNNER_TID, TESTS_STACK_SIZE, TESTS_RUNNER_PRIORITY);
+}
+
+bool TESTS_report(void) {
+	bool passed = true;
+	for (uint32_t i = 0; i < TEST_COUNT; i++) {
+		SerialWrite(tests[i].name);
+		if (results[i] == TEST_PASSED) {
+			SerialWriteLine(": passed");
+			continue;
+		}
+		passed = false;
+		if (results[i] == TEST_FAILED) {
+			SerialWrite(": FAILED, ");
+			SerialWriteLine(failures[i]);
+		} else {
+			SerialWriteLine(": did not finish");
+		}
+	}
+	return passed;
+}
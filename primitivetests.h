@@ -0,0 +1,17 @@
+#ifndef PRIMITIVETESTS_H
+#define PRIMITIVETESTS_H
+#include <stdbool.h>
+
+/*
+ * Functional tests of the synchronization primitives for the simulation
+ * build, each a scenario of a few threads whose interleaving the test
+ * controls: a runner thread spawns lower priority helpers, which only
+ * get to run while it sleeps or blocks, and checks what they did.
+ * TESTS_start spawns the runner (with interrupts disabled, before
+ * OS_startScheduler), TESTS_report prints the outcome of each test over
+ * the serial port and returns false if any failed or did not finish.
+ */
+void TESTS_start(void);
+bool TESTS_report(void);
+
+#endif /* PRIMITIVETESTS_H */
@@ -0,0 +1,205 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include "queue.h"
+#include <stdlib.h>
+
+queue_t create_queue(void* storage, uint32_t itemSize, uint32_t capacity) {
+    queue_t res = MALLOC(sizeof(struct msgQueue));
+    if (!res) return NULL;
+    res->storage = storage;
+    res->itemSize = itemSize;
+    res->stride = (itemSize + 3) & ~3UL;
+    res->capacity = capacity;
+    res->head = 0;
+    res->tail = 0;
+    res->count = 0;
+    res->senders = NULL;
+    res->receivers = NULL;
+    res->set = NULL;
+    return res;
+}
+
+void free_queue(queue_t queue) {
+    FREE(queue);
+}
+
+/*
+ * word by word (four at a time) when both ends and the size are 
+ * word aligned, which is what QUEUE_STORAGE and word sized messages give,
+ * byte by byte otherwise
+ */
+static void copyItem(void* dst, const void* src, uint32_t size) {
+    if ((((uintptr_t)dst | (uintptr_t)src | size) & 3) == 0) {
+        uint32_t* d = dst;
+        const uint32_t* s = src;
+        uint32_t words = size >> 2;
+        while (words >= 4) {
+            d[0] = s[0];
+            d[1] = s[1];
+            d[2] = s[2];
+            d[3] = s[3];
+            d += 4;
+            s += 4;
+            words -= 4;
+        }
+        while (words--) *d++ = *s++;
+        return;
+    }
+    uint8_t* d = dst;
+    const uint8_t* s = src;
+    while (size--) *d++ = *s++;
+}
+
+static uint32_t nextSlot(queue_t queue, uint32_t slot) {
+    slot++;
+    return (slot == queue->capacity) ? 0 : slot;
+}
+
+/*
+ * returns true if the item was sent, *switchNeeded is set if a thread 
+ * that outranks the running one was woken
+ * REQUIRES: interrupts are disabled
+ */
+static bool trySend(queue_t queue, const void* item, bool* switchNeeded) {
+    TCB_t* receiver = OS_waitListHead(queue->receivers);
+    if (receiver != NULL) {
+        // the queue is empty, hand the item straight over
+        copyItem(receiver->pvWaitData, item, queue->itemSize);
+        if (OS_unblockTaskFromISR(receiver)) *switchNeeded = true;
+        return true;
+    }
+    if (queue->count == queue->capacity) return false;
+    copyItem(&queue->storage[queue->tail * queue->stride], item, queue->itemSize);
+    queue->tail = nextSlot(queue, queue->tail);
+    queue->count++;
+    if (queue->set != NULL && queue_set_post_locked(queue->set, queue))
+        *switchNeeded = true;
+    return true;
+}
+
+/*
+ * returns true if an item was received, *switchNeeded as in trySend
+ * REQUIRES: interrupts are disabled
+ */
+static bool tryReceive(queue_t queue, void* buffer, bool* switchNeeded) {
+    if (queue->count == 0) return false;
+    copyItem(buffer, &queue->storage[queue->head * queue->stride], queue->itemSize);
+    queue->head = nextSlot(queue, queue->head);
+    queue->count--;
+
+    // a slot just freed up, move the first blocked sender's item into it
+    TCB_t* sender = OS_waitListHead(queue->senders);
+    if (sender != NULL) {
+        copyItem(&queue->storage[queue->tail * queue->stride], sender->pvWaitData, queue->itemSize);
+        queue->tail = nextSlot(queue, queue->tail);
+        queue->count++;
+        if (OS_unblockTaskFromISR(sender)) *switchNeeded = true;
+        if (queue->set != NULL && queue_set_post_locked(queue->set, queue))
+            *switchNeeded = true;
+    }
+    return true;
+}
+
+bool queue_send(queue_t queue, const void* item, uint32_t ticks) {
+    bool switchNeeded = false;
+    DISABLE_INTERRUPTS();
+    if (trySend(queue, item, &switchNeeded)) {
+        ENABLE_INTERRUPTS();
+        if (switchNeeded) OS_yield();
+        return true;
+    }
+    if (ticks == 0) {
+        ENABLE_INTERRUPTS();
+        return false;
+    }
+    pxCurrentTCB->pvWaitData = (void*)item;
+    OS_blockCurrentTask(&queue->senders, ticks);
+    ENABLE_INTERRUPTS();
+
+    // a receiver copies our item into the queue before waking us
+    return !pxCurrentTCB->xTimedOut;
+}
+
+bool queue_receive(queue_t queue, void* buffer, uint32_t ticks) {
+    bool switchNeeded = false;
+    DISABLE_INTERRUPTS();
+    if (tryReceive(queue, buffer, &switchNeeded)) {
+        ENABLE_INTERRUPTS();
+        if (switchNeeded) OS_yield();
+        return true;
+    }
+    if (ticks == 0) {
+        ENABLE_INTERRUPTS();
+        return false;
+    }
+    pxCurrentTCB->pvWaitData = buffer;
+    OS_blockCurrentTask(&queue->receivers, ticks);
+    ENABLE_INTERRUPTS();
+
+    // a sender copies its item into our buffer before waking us
+    return !pxCurrentTCB->xTimedOut;
+}
+
+bool queue_send_from_isr(queue_t queue, const void* item, bool* higherPriorityTaskWoken) {
+    uint32_t previous = DISABLE_INTERRUPTS_FROM_ISR();
+    bool sent = trySend(queue, item, higherPriorityTaskWoken);
+    ENABLE_INTERRUPTS_FROM_ISR(previous);
+    return sent;
+}
+
+bool queue_receive_from_isr(queue_t queue, void* buffer, bool* higherPriorityTaskWoken) {
+    uint32_t previous = DISABLE_INTERRUPTS_FROM_ISR();
+    bool received = tryReceive(queue, buffer, higherPriorityTaskWoken);
+    ENABLE_INTERRUPTS_FROM_ISR(previous);
+    return received;
+}
+
+uint32_t queue_messages_waiting(queue_t queue) {
+    return queue->count;
+}
+
+queueset_t create_queue_set(uint32_t capacity) {
+    queueset_t res = MALLOC(sizeof(struct queueSet));
+    if (!res) return NULL;
+    void* handles = MALLOC(capacity * sizeof(void*));
+    if (!handles) {
+        FREE(res);
+        return NULL;
+    }
+    res->ready = create_queue(handles, sizeof(void*), capacity);
+    if (!res->ready) {
+        FREE(handles);
+        FREE(res);
+        return NULL;
+    }
+    return res;
+}
+
+void free_queue_set(queueset_t set) {
+    FREE(set->ready->storage);
+    free_queue(set->ready);
+    FREE(set);
+}
+
+void queue_set_add_queue(queueset_t set, queue_t queue) {
+    queue->set = set;
+}
+
+bool queue_set_post_locked(queueset_t set, void* member) {
+    bool switchNeeded = false;
+    trySend(set->ready, &member, &switchNeeded);
+    return switchNeeded;
+}
+
+void* queue_set_select(queueset_t set, uint32_t ticks) {
+    void* member;
+    if (!queue_receive(set->ready, &member, ticks)) return NULL;
+    return member;
+}
+
+void* queue_set_select_from_isr(queueset_t set, bool* higherPriorityTaskWoken) {
+    void* member;
+    if (!queue_receive_from_isr(set->ready, &member, higherPriorityTaskWoken)) return NULL;
+    return member;
+}
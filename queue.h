@@ -0,0 +1,127 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include <stdlib.h>
+
+#ifndef QUEUES
+#define QUEUES
+
+struct queueSet;
+
+/*
+ * Fixed capacity queue of fixed size items, copied in and out by value.
+ * Items live in a ring buffer the caller provides (see QUEUE_STORAGE),
+ * so nothing is allocated per message.
+ * When a receiver is already waiting, a send copies straight into its 
+ * buffer, and a receive from a full queue pulls a waiting sender's item
+ * straight into the freed slot, so every item is copied at most twice.
+ */
+struct msgQueue
+{
+    uint8_t* storage;       // capacity slots of stride bytes
+    uint32_t itemSize;
+    uint32_t stride;        // itemSize rounded up to a whole word
+    uint32_t capacity;
+    uint32_t head;          // slot of the oldest item
+    uint32_t tail;          // slot the next item goes in
+    volatile uint32_t count;
+    list_t senders;         // threads blocked on a full queue, highest priority first
+    list_t receivers;       // threads blocked on an empty queue, highest priority first
+    struct queueSet* set;   // set this queue is a member of, NULL if none
+};
+
+typedef struct msgQueue *queue_t;
+
+/*
+ * declares word aligned storage for a queue of capacity items of itemSize bytes
+ */
+#define QUEUE_STORAGE(name, itemSize, capacity) \
+    uint32_t name[(((itemSize) + 3) / 4) * (capacity)]
+
+/*
+ * REQUIRES: storage holds capacity items, declared with QUEUE_STORAGE
+ *           capacity > 0
+ */
+queue_t create_queue(void* storage, uint32_t itemSize, uint32_t capacity);
+
+/*
+ * REQUIRES: no thread is blocked on the queue
+ */
+void free_queue(queue_t queue);
+
+/*
+ * Copies item to the back of the queue, blocking for up to ticks 
+ * system ticks while the queue is full.
+ * Returns true if sent, false on timeout.
+ */
+bool queue_send(queue_t queue, const void* item, uint32_t ticks);
+
+/*
+ * Copies the front item of the queue into buffer and removes it,
+ * blocking for up to ticks system ticks while the queue is empty.
+ * Returns true if received, false on timeout.
+ */
+bool queue_receive(queue_t queue, void* buffer, uint32_t ticks);
+
+/*
+ * Non-blocking queue_send/queue_receive for interrupt handlers, return 
+ * false if the queue is full/empty. See OS_SignalFromISR for 
+ * higherPriorityTaskWoken.
+ */
+bool queue_send_from_isr(queue_t queue, const void* item, bool* higherPriorityTaskWoken);
+bool queue_receive_from_isr(queue_t queue, void* buffer, bool* higherPriorityTaskWoken);
+
+uint32_t queue_messages_waiting(queue_t queue);
+
+/*
+ * Queue sets let one thread block on several queues and semaphores at once.
+ * Each member keeps a pointer to its set, and whenever it gains an item
+ * (or a count) it posts its own handle into the set's queue, so adding a
+ * member is O(1) and waking the selecting thread never scans the members.
+ * queue_set_select returns a member that is ready, which the caller then
+ * reads with a 0 tick queue_receive / OS_WaitTimeout.
+ * Don't block on a member directly: items handed to a thread blocked on the
+ * member never go through the set.
+ */
+struct queueSet
+{
+    queue_t ready;          // handles of members, one per item they hold
+};
+
+typedef struct queueSet *queueset_t;
+
+/*
+ * REQUIRES: capacity is at least the number of items all the members can
+ *           hold together (queue capacities plus semaphore counts)
+ */
+queueset_t create_queue_set(uint32_t capacity);
+
+/*
+ * REQUIRES: no thread is blocked on the set, and it has no members left
+ */
+void free_queue_set(queueset_t set);
+
+/*
+ * REQUIRES: the queue is empty and not a member of another set
+ */
+void queue_set_add_queue(queueset_t set, queue_t queue);
+
+/*
+ * Blocks for up to ticks system ticks until a member has an item.
+ * Returns that member's handle (the queue_t or csemaphore_t), NULL on timeout.
+ */
+void* queue_set_select(queueset_t set, uint32_t ticks);
+
+/*
+ * non-blocking queue_set_select for interrupt handlers, see OS_SignalFromISR
+ */
+void* queue_set_select_from_isr(queueset_t set, bool* higherPriorityTaskWoken);
+
+/*
+ * posts member into set, for members other than queues (see semaphore.c)
+ * Returns true if it woke a thread that outranks the running one.
+ * REQUIRES: interrupts are disabled
+ */
+bool queue_set_post_locked(queueset_t set, void* member);
+
+#endif
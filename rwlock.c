@@ -0,0 +1,104 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include "rwlock.h"
+#include <stdlib.h>
+
+rwlock_t create_rwlock(bool writerPreferred) {
+    rwlock_t res = MALLOC(sizeof(struct rwlock));
+    if (!res) return NULL;
+    res->readQueue = NULL;
+    res->writeQueue = NULL;
+    res->readers = 0;
+    res->writer = NULL;
+    res->writerPreferred = writerPreferred;
+    return res;
+}
+
+void free_rwlock(rwlock_t lock) {
+    FREE(lock);
+}
+
+/*
+ * hands the lock to the next writer, or to every waiting reader at once
+ * REQUIRES: interrupts are disabled, the lock is free
+ */
+static void wakeWaiters(rwlock_t lock) {
+    bool writerFirst = lock->writerPreferred || lock->readQueue == NULL;
+    if (writerFirst && lock->writeQueue != NULL) {
+        lock->writer = OS_waitListHead(lock->writeQueue);
+        OS_unblockTask(lock->writer);
+        return;
+    }
+    while (lock->readQueue != NULL) {
+        lock->readers++;
+        OS_unblockTask(OS_waitListHead(lock->readQueue));
+    }
+}
+
+bool acquire_read_timeout(rwlock_t lock, uint32_t ticks) {
+    DISABLE_INTERRUPTS();
+    bool writerWaiting = lock->writerPreferred && lock->writeQueue != NULL;
+    if (lock->writer == NULL && !writerWaiting) {
+        lock->readers++;
+        ENABLE_INTERRUPTS();
+        return true;
+    }
+    if (ticks == 0) {
+        ENABLE_INTERRUPTS();
+        return false;
+    }
+    OS_blockCurrentTask(&lock->readQueue, ticks);
+    ENABLE_INTERRUPTS();
+
+    // the releasing thread counts us in before waking us up
+    return !pxCurrentTCB->xTimedOut;
+}
+
+bool acquire_write_timeout(rwlock_t lock, uint32_t ticks) {
+    DISABLE_INTERRUPTS();
+    if (lock->writer == NULL && lock->readers == 0) {
+        lock->writer = pxCurrentTCB;
+        ENABLE_INTERRUPTS();
+        return true;
+    }
+    if (ticks == 0) {
+        ENABLE_INTERRUPTS();
+        return false;
+    }
+    OS_blockCurrentTask(&lock->writeQueue, ticks);
+    ENABLE_INTERRUPTS();
+    if (lock->writer == pxCurrentTCB) return true;
+
+    // readers may have been queued up only because we were waiting
+    DISABLE_INTERRUPTS();
+    if (lock->writer == NULL && lock->writeQueue == NULL)
+        wakeWaiters(lock);
+    ENABLE_INTERRUPTS();
+    return false;
+}
+
+void acquire_read(rwlock_t lock) {
+    acquire_read_timeout(lock, OS_WAIT_FOREVER);
+}
+
+void acquire_write(rwlock_t lock) {
+    acquire_write_timeout(lock, OS_WAIT_FOREVER);
+}
+
+void release_read(rwlock_t lock) {
+    DISABLE_INTERRUPTS();
+    lock->readers--;
+    if (lock->readers == 0 && lock->writeQueue != NULL) {
+        lock->writer = OS_waitListHead(lock->writeQueue);
+        OS_unblockTask(lock->writer);
+    }
+    ENABLE_INTERRUPTS();
+}
+
+void release_write(rwlock_t lock) {
+    DISABLE_INTERRUPTS();
+    lock->writer = NULL;
+    wakeWaiters(lock);
+    ENABLE_INTERRUPTS();
+}
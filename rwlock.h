@@ -0,0 +1,47 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include <stdlib.h>
+
+#ifndef RWLOCKS
+#define RWLOCKS
+
+/*
+ * Reader-writer lock: any number of readers can hold the lock at once,
+ * writers get it exclusively.
+ * With writer preference a waiting writer holds back new readers and
+ * is served before them, so a steady stream of readers cannot starve it.
+ * Without it readers only wait while a writer holds the lock.
+ */
+struct rwlock
+{
+    list_t readQueue;       // readers blocked on the lock
+    list_t writeQueue;      // writers blocked on the lock, highest priority first
+    uint32_t readers;       // threads currently holding the read lock
+    TCB_t* writer;          // thread holding the write lock, NULL if none
+    bool writerPreferred;
+};
+
+typedef struct rwlock *rwlock_t;
+
+rwlock_t create_rwlock(bool writerPreferred);
+
+/*
+ * REQUIRES: no thread holds or is blocked on the lock
+ */
+void free_rwlock(rwlock_t lock);
+
+void acquire_read(rwlock_t lock);
+void acquire_write(rwlock_t lock);
+
+/*
+ * Same as acquire_read/acquire_write, but give up after ticks system ticks.
+ * Return true if the lock was acquired, false on timeout.
+ */
+bool acquire_read_timeout(rwlock_t lock, uint32_t ticks);
+bool acquire_write_timeout(rwlock_t lock, uint32_t ticks);
+
+void release_read(rwlock_t lock);
+void release_write(rwlock_t lock);
+
+#endif
@@ -1,20 +1,363 @@
 #include <stdint.h>
 #include <stdbool.h>
-#include "15348.h"
-#include "timer.h"
 #include "serial.h"
 #include <stddef.h>
 
 #include "lists.h"
 #include "scheduler.h"
-//extern struct taskControlBlock* pxCurrentTCB;
-//extern struct taskControlBlock* tmpThread1;
-//extern struct taskControlBlock* tmpThread2;
+#include "staticMalloc.h"
+
+#define IDLE_STACK_SIZE (96)
+
+TCB_t* pxCurrentTCB = NULL;
+TCB_t* pxNextTCB = NULL;
+list_t readyLists[NUM_PRIORITIES];
+
+#ifdef portCOUNT_LEADING_ZEROS
+// bit 31 - p is set while readyLists[p] is not empty, so the highest
+// priority ready thread is found with a single count leading zeros
+static uint32_t readyPriorities = 0;
+#define READY_BIT(priority)		(0x80000000UL >> (priority))
+#endif
+
+// threads sleeping until a tick, ordered by the tick they wake up at
+list_t delayedList = NULL;
+volatile uint32_t xTickCount = 0;
+
+void initReadyLists() {
+    int i;
+    for (i = 0; i < NUM_PRIORITIES; i++)
+        readyLists[i] = NULL;
+}
+
+TCB_t* OS_switchToNextTask(void) {
+    /* 
+        do any policies like priority upgrades here
+    */
+
+    //round robin scheduler among threads of same priority, 
+    // going through priorities in ascending order
+#ifdef portCOUNT_LEADING_ZEROS
+    if (readyPriorities != 0) {
+        uint32_t i = portCOUNT_LEADING_ZEROS(readyPriorities);
+        pxNextTCB = (TCB_t *)readyLists[i]->data;
+        readyLists[i] = readyLists[i]->next;
+        return pxNextTCB;
+    }
+#else
+    int i;
+    for (i = 0; i < NUM_PRIORITIES; i++) {
+        if (readyLists[i] != NULL) {
+            pxNextTCB = (TCB_t *)readyLists[i]->data;
+            readyLists[i] = readyLists[i]->next;
+            return pxNextTCB;
+        }
+    }
+#endif
+    pxNextTCB = pxCurrentTCB; //or perhaps, a default idle thread's TCB
+    return pxNextTCB;
+}
+
+/*
+ * Returns NULL if the stack or the TCB cannot be allocated
+ * REQUIRES: addresses returned by MALLOC are (at least) 8 byte aligned
+ */
+TCB_t* OS_spawnThread(void (*program)(void), uint32_t tid, 
+					uint32_t stack_size, uint32_t priority) {
+	void* stack = MALLOC(stack_size);
+	if (stack == NULL) return NULL;
+	TCB_t* newTCB = (TCB_t*)MALLOC(sizeof(TCB_t));
+	if (newTCB == NULL) {
+		FREE(stack);
+		return NULL;
+	}
+	newTCB->uxPriority = priority;
+	newTCB->uxThreadId = tid;
+	newTCB->pxTopOfStack = stack;
+	newTCB->pxStack = portInitialiseStack((uint32_t*)&((uint8_t*)stack)[stack_size], program);
+	newTCB->xListEntry = create_circular_list((void *)newTCB);
+	newTCB->xEventListEntry = create_circular_list((void *)newTCB);
+	newTCB->pxWaitList = NULL;
+	newTCB->xWakeTick = 0;
+	newTCB->xTimedOut = false;
+	newTCB->pvWaitData = NULL;
+	newTCB->ulNotifiedValue = 0;
+	newTCB->ucNotifyState = NOTIFY_NOT_WAITING;
+#if configUSE_DEADLOCK_DETECTION
+	newTCB->pxBlockedOnMutex = NULL;
+#endif
+	OS_addToReadyList(newTCB);
+	return newTCB;
+}
+
+void OS_yield(void) {
+	portYIELD();
+}
+
+/*
+ * runs whenever no other thread is ready, so that a blocked thread
+ * never has to be switched back in
+ */
+static void OS_idleThread(void) {
+	while (1) {
+		portIDLE();
+	}
+}
+
+/*
+ * REQUIRES: kernel interrupts are still disabled (see main), so that no 
+ *           tick or switch can happen before the first thread is running
+ */
+void OS_startScheduler(void) {
+	OS_spawnThread(&OS_idleThread, 0xFFFFFFFF, IDLE_STACK_SIZE, NUM_PRIORITIES - 1);
+	portSETUP_CYCLE_COUNTER();
+	portSetupTimerInterrupt();
+	pxCurrentTCB = OS_switchToNextTask();
+	portStartScheduler();
+}
+
+/*
+ * removes node from the circular list whose head is *lst,
+ * moving the head along if node was the head
+ */
+static void removeFromList(list_t* lst, list_t node) {
+	if (*lst == node) *lst = unlink_node(node);
+	else unlink_node(node);
+}
+
+/*
+ * takes the thread off the ready list of its priority
+ */
+static void removeFromReadyList(TCB_t* task) {
+	removeFromList(&readyLists[task->uxPriority], task->xListEntry);
+#ifdef portCOUNT_LEADING_ZEROS
+	if (readyLists[task->uxPriority] == NULL)
+		readyPriorities &= ~READY_BIT(task->uxPriority);
+#endif
+}
+
+/*
+ * links node in at the back of the circular list whose head is *lst
+ */
+static void appendToList(list_t* lst, list_t node) {
+	if (*lst == NULL) *lst = link_as_next(NULL, node);
+	else link_as_next((*lst)->prev, node);
+}
+
+/*
+ * adds the thread at the back of the round robin order of its priority
+ */
+void OS_addToReadyList(TCB_t* task) {
+	appendToList(&readyLists[task->uxPriority], task->xListEntry);
+#ifdef portCOUNT_LEADING_ZEROS
+	readyPriorities |= READY_BIT(task->uxPriority);
+#endif
+}
+
+/*
+ * waiters are ordered by priority, FIFO among threads of the same priority
+ */
+static bool outranks(TCB_t* a, TCB_t* b) {
+	return a->uxPriority < b->uxPriority;
+}
+
 /*
-void OS_switchToNextTask(void) {
-	//pxCurrentTask = pxCurrentTask->xListEntry->next;
-	if (tmpThread1 == NULL || tmpThread2 == NULL) return;
-	if (pxCurrentTCB == tmpThread1) pxCurrentTCB = tmpThread2;
-	if (pxCurrentTCB == tmpThread2) pxCurrentTCB = tmpThread1;
+ * delayed threads are ordered by wake up tick, the subtraction keeps the
+ * order right when the tick count wraps around
+ */
+static bool wakesBefore(TCB_t* a, TCB_t* b) {
+	return (int32_t)(a->xWakeTick - b->xWakeTick) < 0;
+}
+
+/*
+ * inserts node before the first node it should go before, or at the
+ * back of the list if there is none
+ */
+static void insertOrdered(list_t* lst, list_t node, bool (*before)(TCB_t*, TCB_t*)) {
+	list_t head = *lst;
+	if (head == NULL) {
+		*lst = link_as_next(NULL, node);
+		return;
+	}
+	list_t cur = head;
+	do {
+		if (before((TCB_t*)node->data, (TCB_t*)cur->data)) {
+			link_as_next(cur->prev, node);
+			if (cur == head) *lst = node;
+			return;
+		}
+		cur = cur->next;
+	} while (cur != head);
+	link_as_next(head->prev, node);
+}
+
+void OS_blockCurrentTask(list_t* waitList, uint32_t ticks) {
+	OS_blockCurrentTaskOrdered(waitList, ticks, WAIT_ORDER_PRIORITY);
+}
+
+void OS_blockCurrentTaskOrdered(list_t* waitList, uint32_t ticks, waitOrder_t order) {
+	TCB_t* task = pxCurrentTCB;
+	removeFromReadyList(task);
+	task->xTimedOut = false;
+	if (waitList != NULL) {
+		// FIFO waiters always go to the back
+		if (order == WAIT_ORDER_FIFO) appendToList(waitList, task->xEventListEntry);
+		else insertOrdered(waitList, task->xEventListEntry, &outranks);
+		task->pxWaitList = waitList;
+	}
+	if (ticks != OS_WAIT_FOREVER) {
+		task->xWakeTick = xTickCount + ticks;
+		insertOrdered(&delayedList, task->xListEntry, &wakesBefore);
+	}
+	OS_yield();
+}
+
+void OS_unblockTask(TCB_t* task) {
+	if (OS_unblockTaskFromISR(task))
+		OS_yield();
+}
+
+bool OS_unblockTaskFromISR(TCB_t* task) {
+	if (task->pxWaitList != NULL) {
+		removeFromList(task->pxWaitList, task->xEventListEntry);
+		task->pxWaitList = NULL;
+	}
+#if configUSE_DEADLOCK_DETECTION
+	task->pxBlockedOnMutex = NULL;
+#endif
+	// a notification that arrives after the timeout must not unblock it again
+	if (task->ucNotifyState == NOTIFY_WAITING)
+		task->ucNotifyState = NOTIFY_NOT_WAITING;
+	// no-op for threads that were blocked without a timeout
+	removeFromList(&delayedList, task->xListEntry);
+	OS_addToReadyList(task);
+	return pxCurrentTCB != NULL && outranks(task, pxCurrentTCB);
+}
+
+TCB_t* OS_waitListHead(list_t waitList) {
+	return (waitList == NULL) ? NULL : (TCB_t*)waitList->data;
+}
+
+void OS_tickIncrement(void) {
+	xTickCount++;
+	while (delayedList != NULL) {
+		TCB_t* task = (TCB_t*)delayedList->data;
+		if ((int32_t)(xTickCount - task->xWakeTick) < 0) break;
+		task->xTimedOut = true;
+		OS_unblockTask(task);
+	}
+}
+
+void OS_Delay(uint32_t ticks) {
+	DISABLE_INTERRUPTS();
+	OS_blockCurrentTask(NULL, ticks);
+	ENABLE_INTERRUPTS();
+}
+
+/*
+ * what a thread blocked in OS_NotifyWait/OS_NotifyTake wants done with the
+ * notification that wakes it, kept in its pvWaitData. The notifier does
+ * it and hands the result over, the way a semaphore hands its count to
+ * the thread it wakes, so the woken thread has nothing left to do.
+ */
+struct notifyWaiter {
+	bool take;				// OS_NotifyTake: count down instead of clearing bits
+	uint32_t clearOnExit;	// bits to clear, for OS_NotifyTake non-zero to zero the count
+	uint32_t value;			// the notification value when it was received
+	bool received;
+};
+
+/*
+ * takes the pending notification, if any, as waiter asks and stores the
+ * result in it
+ * REQUIRES: interrupts are disabled
+ */
+static void collectNotification(TCB_t* task, struct notifyWaiter* waiter) {
+	uint32_t value = task->ulNotifiedValue;
+	if (waiter->take) {
+		waiter->received = (value != 0);
+		if (value != 0) task->ulNotifiedValue = waiter->clearOnExit ? 0 : value - 1;
+	} else {
+		waiter->received = (task->ucNotifyState == NOTIFY_RECEIVED);
+		if (waiter->received) task->ulNotifiedValue &= ~waiter->clearOnExit;
+	}
+	waiter->value = value;
+	task->ucNotifyState = NOTIFY_NOT_WAITING;
+}
+
+/*
+ * returns true if task was waiting and outranks the running thread
+ * REQUIRES: interrupts are disabled
+ */
+static bool notify(TCB_t* task, uint32_t value, notifyAction_t action) {
+	switch (action) {
+		case NOTIFY_SET_BITS:
+			task->ulNotifiedValue |= value;
+			break;
+		case NOTIFY_INCREMENT:
+			task->ulNotifiedValue++;
+			break;
+		case NOTIFY_OVERWRITE:
+			task->ulNotifiedValue = value;
+			break;
+	}
+	bool waiting = (task->ucNotifyState == NOTIFY_WAITING);
+	task->ucNotifyState = NOTIFY_RECEIVED;
+	if (!waiting) return false;
+	collectNotification(task, (struct notifyWaiter*)task->pvWaitData);
+	return OS_unblockTaskFromISR(task);
+}
+
+/*
+ * blocks the running thread until it is notified or ticks pass (only if
+ * block), then leaves the outcome in waiter
+ * REQUIRES: interrupts are disabled, they are enabled on return
+ */
+static void waitForNotification(struct notifyWaiter* waiter, bool block, uint32_t ticks) {
+	TCB_t* task = pxCurrentTCB;
+	if (block) {
+		task->pvWaitData = waiter;
+		task->ucNotifyState = NOTIFY_WAITING;
+		OS_blockCurrentTask(NULL, ticks);
+		ENABLE_INTERRUPTS();
+		// woken by a notification, which already filled waiter in
+		if (!task->xTimedOut) return;
+		DISABLE_INTERRUPTS();
+	}
+	// one may still have arrived between the timeout and now
+	collectNotification(task, waiter);
+	ENABLE_INTERRUPTS();
+}
+
+void OS_Notify(TCB_t* task, uint32_t value, notifyAction_t action) {
+	DISABLE_INTERRUPTS();
+	bool switchNeeded = notify(task, value, action);
+	ENABLE_INTERRUPTS();
+	if (switchNeeded) OS_yield();
+}
+
+void OS_NotifyFromISR(TCB_t* task, uint32_t value, notifyAction_t action, 
+					  bool* higherPriorityTaskWoken) {
+	uint32_t previous = DISABLE_INTERRUPTS_FROM_ISR();
+	if (notify(task, value, action)) *higherPriorityTaskWoken = true;
+	ENABLE_INTERRUPTS_FROM_ISR(previous);
+}
+
+bool OS_NotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, 
+				   uint32_t* value, uint32_t ticks) {
+	TCB_t* task = pxCurrentTCB;
+	struct notifyWaiter waiter = { false, clearOnExit, 0, false };
+	DISABLE_INTERRUPTS();
+	bool pending = (task->ucNotifyState == NOTIFY_RECEIVED);
+	if (!pending) task->ulNotifiedValue &= ~clearOnEntry;
+	waitForNotification(&waiter, !pending && ticks != 0, ticks);
+	if (value != NULL) *value = waiter.value;
+	return waiter.received;
+}
+
+uint32_t OS_NotifyTake(bool clearOnExit, uint32_t ticks) {
+	struct notifyWaiter waiter = { true, clearOnExit, 0, false };
+	DISABLE_INTERRUPTS();
+	waitForNotification(&waiter, pxCurrentTCB->ulNotifiedValue == 0 && ticks != 0, ticks);
+	return waiter.value;
 }
-*/
\ No newline at end of file
@@ -1,6 +1,180 @@
 /**
  * Pre-emtive scheduler for the OS
  * for now simply uses a round-robin scheduling algorithm
+ * among the highest priority ready threads
  */
- 
-//void OS_switchToNextTask(void);
\ No newline at end of file
+#include <stdint.h>
+#include "lists.h"
+#include "OSConfig.h"
+#include "port.h"
+
+#ifndef SCHEDULER
+#define SCHEDULER
+
+#define NUM_PRIORITIES 4
+
+// pass as ticks to any blocking call to wait without a timeout
+#define OS_WAIT_FOREVER (0xFFFFFFFF)
+
+struct mutex;
+
+// ucNotifyState values
+#define NOTIFY_NOT_WAITING	0
+#define NOTIFY_WAITING		1	// blocked in OS_NotifyWait/OS_NotifyTake
+#define NOTIFY_RECEIVED		2	// notified since it last waited
+
+// how OS_Notify updates the thread's notification value
+typedef enum {
+	NOTIFY_SET_BITS,		// value |= bits, for event flags
+	NOTIFY_INCREMENT,		// value++, for a counting semaphore (value is ignored)
+	NOTIFY_OVERWRITE		// value = value, for a mailbox holding the latest word
+} notifyAction_t;
+
+// order in which threads blocked on a kernel object are woken up
+typedef enum {
+	WAIT_ORDER_PRIORITY,	// highest priority first, FIFO among equal priorities
+	WAIT_ORDER_FIFO			// first come first served
+} waitOrder_t;
+
+struct taskControlBlock {
+	uint32_t* pxStack;			// base SP for this thread
+	uint32_t* pxTopOfStack;		// current SP for this thread, TODO: should be volatile?
+	list_t xListEntry;		// link back to the list item this TCB is in. This list item should include what list it's in
+	list_t xEventListEntry;	// list item for the wait list of the object this thread is blocked on
+	list_t* pxWaitList;		// wait list this thread is blocked on, NULL if none
+	uint32_t xWakeTick;		// tick at which a delayed thread is woken up
+	bool xTimedOut;			// set when the thread was woken by its timeout rather than the object
+	void* pvWaitData;		// parameters/result of the blocking call, owned by the object it waits on
+	volatile uint32_t ulNotifiedValue;	// direct to task notification word, see OS_Notify
+	volatile uint8_t ucNotifyState;		// NOTIFY_NOT_WAITING / NOTIFY_WAITING / NOTIFY_RECEIVED
+#if configUSE_DEADLOCK_DETECTION
+	struct mutex* pxBlockedOnMutex;	// mutex this thread is blocked on, NULL if none
+#endif
+	uint32_t uxPriority;		// current priority of this thread
+	uint32_t uxThreadId;		// ID for this thread
+};
+typedef struct taskControlBlock TCB_t;
+
+// the task that is currently running, NULL until the scheduler starts
+extern TCB_t* pxCurrentTCB;
+extern TCB_t* pxNextTCB;
+extern list_t readyLists[NUM_PRIORITIES];
+extern volatile uint32_t xTickCount;
+
+/*
+ * call once at the end of an interrupt handler that used FromISR calls:
+ * if any of them woke a thread that outranks the interrupted one, the
+ * switch to it happens as soon as the handler returns
+ */
+#define OS_YIELD_FROM_ISR(higherPriorityTaskWoken) \
+{												\
+	if (higherPriorityTaskWoken) OS_yield();	\
+}
+
+void initReadyLists(void);
+/*
+ * returns the new thread's TCB, which doubles as its handle (e.g. for OS_Notify),
+ * or NULL if there is not enough memory for it
+ * A thread that uses floating point needs 136 more bytes of stack when 
+ * configUSE_FPU is on, for S0-S31 and FPSCR.
+ */
+TCB_t* OS_spawnThread(void (*program)(void), uint32_t tid, 
+					uint32_t stack_size, uint32_t priority);
+/*
+ * picks the thread to run next and returns it (also left in pxNextTCB),
+ * called by PendSV with the outgoing thread's context already saved
+ */
+TCB_t* OS_switchToNextTask(void);
+void OS_addToReadyList(TCB_t* task);
+
+/*
+ * spawns the idle thread and runs the highest priority ready thread,
+ * never returns
+ */
+void OS_startScheduler(void);
+
+/*
+ * pends a context switch, which happens as soon as interrupts are enabled
+ */
+void OS_yield(void);
+
+/*
+ * Moves the running thread off its ready list. If waitList is not NULL the
+ * thread is queued on it by priority (FIFO among equal priorities), and if
+ * ticks is not OS_WAIT_FOREVER it is also put on the delayed list, whichever
+ * wakes it first takes it off the other.
+ * REQUIRES: interrupts are disabled, the switch happens once they are enabled
+ */
+void OS_blockCurrentTask(list_t* waitList, uint32_t ticks);
+
+/*
+ * Same as OS_blockCurrentTask, with the order the thread is queued in
+ * given by order
+ */
+void OS_blockCurrentTaskOrdered(list_t* waitList, uint32_t ticks, waitOrder_t order);
+
+/*
+ * Takes a blocked thread off its wait list and the delayed list and makes it
+ * ready again, pending a switch if it outranks the running thread
+ * REQUIRES: interrupts are disabled
+ */
+void OS_unblockTask(TCB_t* task);
+
+/*
+ * Same as OS_unblockTask, but instead of pending a switch returns true
+ * if the thread outranks the running one, for OS_YIELD_FROM_ISR
+ * REQUIRES: interrupts are disabled
+ */
+bool OS_unblockTaskFromISR(TCB_t* task);
+
+/*
+ * Returns the highest priority thread waiting on waitList, NULL if none
+ */
+TCB_t* OS_waitListHead(list_t waitList);
+
+/*
+ * Advances the tick count and wakes up every thread whose timeout expired
+ * REQUIRES: interrupts are disabled
+ */
+void OS_tickIncrement(void);
+
+/*
+ * Blocks the calling thread for the given number of ticks
+ */
+void OS_Delay(uint32_t ticks);
+
+/*
+ * Direct to task notifications: every thread has a notification word in its
+ * TCB that other threads and interrupt handlers can update and wake it 
+ * with, without a separate kernel object or any allocation.
+ */
+
+/*
+ * Updates task's notification value and wakes it if it is waiting
+ */
+void OS_Notify(TCB_t* task, uint32_t value, notifyAction_t action);
+
+/*
+ * OS_Notify for interrupt handlers, see OS_SignalFromISR
+ */
+void OS_NotifyFromISR(TCB_t* task, uint32_t value, notifyAction_t action, 
+					  bool* higherPriorityTaskWoken);
+
+/*
+ * Waits until the calling thread is notified.
+ * Bits in clearOnEntry are cleared from the notification value before waiting
+ * (if no notification is pending), bits in clearOnExit after receiving one.
+ * The value is stored in *value if value is not NULL.
+ * Returns true if notified, false on timeout.
+ */
+bool OS_NotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, 
+				   uint32_t* value, uint32_t ticks);
+
+/*
+ * Uses the notification value as a counting semaphore given with 
+ * NOTIFY_INCREMENT: waits until it is non-zero, then decrements it, or 
+ * zeroes it if clearOnExit. Returns the value before that, 0 on timeout.
+ */
+uint32_t OS_NotifyTake(bool clearOnExit, uint32_t ticks);
+
+#endif
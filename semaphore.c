@@ -1,22 +1,162 @@
 /**
   * Semaphore implementation 
   *
+  * counts are updated with LDREX/STREX instead of disabling interrupts
   */
-#include "semaphore.h""
+#include "semaphore.h"
+#include "scheduler.h"
+#include "staticMalloc.h"
+#include <stddef.h>
 
 void OS_WaitNaive(semaphore_t* s) {
-	__asm("CPSID I");
-	while ((*s) == 0) {
-		__asm("CPSIE I");
-		__asm("NOP");
-		__asm("CPSID I");
+	while (1) {
+		uint32_t count = __load_exclusive(s);
+		if (count == 0) {
+			__clear_exclusive();
+			__asm("NOP");
+			continue;
+		}
+		if (__store_exclusive(count - 1, s) == 0) return;
 	}
-	(*s)--;
-	__asm("CPSIE I");
 }
 
 void OS_SignalNaive(semaphore_t* s) {
-	__asm("CPSID I");
-	(*s)++;
-	__asm("CPSIE I");
+	uint32_t count;
+	do {
+		count = __load_exclusive(s);
+	} while (__store_exclusive(count + 1, s));
+}
+
+/*
+ * A naive semaphore has no wait list to block on, so instead of spinning 
+ * the caller sleeps on the delayed list for a tick between checks
+ */
+bool OS_WaitNaiveTimeout(semaphore_t* s, uint32_t ticks) {
+	uint32_t start = xTickCount;
+	while (1) {
+		uint32_t count = __load_exclusive(s);
+		if (count == 0) {
+			__clear_exclusive();
+			if (ticks != OS_WAIT_FOREVER && xTickCount - start >= ticks)
+				return false;
+			OS_Delay(1);
+			continue;
+		}
+		if (__store_exclusive(count - 1, s) == 0) return true;
+	}
+}
+
+csemaphore_t create_semaphore(uint32_t count, waitOrder_t order) {
+	csemaphore_t res = MALLOC(sizeof(struct semaphore));
+	if (!res) return NULL;
+	res->state = count;
+	res->waitList = NULL;
+	res->order = order;
+	res->set = NULL;
+	return res;
+}
+
+void free_semaphore(csemaphore_t s) {
+	FREE(s);
+}
+
+void OS_Wait(csemaphore_t s) {
+	OS_WaitTimeout(s, OS_WAIT_FOREVER);
+}
+
+bool OS_WaitTimeout(csemaphore_t s, uint32_t ticks) {
+	// fast path: take a count if there is one
+	uint32_t state;
+	do {
+		state = __load_exclusive(&s->state);
+		if (SEM_COUNT(state) == 0) {
+			__clear_exclusive();
+			break;
+		}
+	} while (__store_exclusive(state - 1, &s->state));
+	if (SEM_COUNT(state) > 0) return true;
+	
+	// slow path: a fast path interrupted by us fails its store and 
+	// retries, so plain updates are safe with interrupts disabled
+	DISABLE_INTERRUPTS();
+	if (SEM_COUNT(s->state) > 0) {
+		s->state--;
+		ENABLE_INTERRUPTS();
+		return true;
+	}
+	if (ticks == 0) {
+		ENABLE_INTERRUPTS();
+		return false;
+	}
+	s->state += SEM_ONE_WAITER;
+	OS_blockCurrentTaskOrdered(&s->waitList, ticks, s->order);
+	ENABLE_INTERRUPTS();
+	
+	// OS_Signal gives the count to the thread it wakes, and takes it
+	// off the waiter count, without incrementing
+	if (!pxCurrentTCB->xTimedOut) return true;
+	DISABLE_INTERRUPTS();
+	s->state -= SEM_ONE_WAITER;
+	ENABLE_INTERRUPTS();
+	return false;
+}
+
+/*
+ * fast path of both signals: if nobody is waiting just add to the count,
+ * which stays at SEMAPHORE_MAX_COUNT rather than carry into the waiters.
+ * Returns false if there are waiters, or a set to post to, and the slow
+ * path has to run
+ */
+static bool signalFast(csemaphore_t s) {
+	uint32_t state;
+	if (s->set != NULL) return false;
+	do {
+		state = __load_exclusive(&s->state);
+		if (SEM_WAITERS(state) != 0) {
+			__clear_exclusive();
+			return false;
+		}
+		if (SEM_COUNT(state) == SEMAPHORE_MAX_COUNT) {
+			__clear_exclusive();
+			return true;
+		}
+	} while (__store_exclusive(state + 1, &s->state));
+	return true;
+}
+
+/*
+ * wakes the first waiter, returns true if it outranks the running thread
+ * REQUIRES: interrupts are disabled
+ */
+static bool signalSlow(csemaphore_t s) {
+	TCB_t* next = OS_waitListHead(s->waitList);
+	if (next == NULL) {
+		// no waiters (or they timed out and have not cleaned up yet)
+		if (SEM_COUNT(s->state) == SEMAPHORE_MAX_COUNT) return false;
+		s->state++;
+		return s->set != NULL && queue_set_post_locked(s->set, s);
+	}
+	s->state -= SEM_ONE_WAITER;
+	return OS_unblockTaskFromISR(next);
+}
+
+void OS_Signal(csemaphore_t s) {
+	if (signalFast(s)) return;
+	
+	DISABLE_INTERRUPTS();
+	bool switchNeeded = signalSlow(s);
+	ENABLE_INTERRUPTS();
+	if (switchNeeded) OS_yield();
+}
+
+void OS_SignalFromISR(csemaphore_t s, bool* higherPriorityTaskWoken) {
+	if (signalFast(s)) return;
+	
+	uint32_t previous = DISABLE_INTERRUPTS_FROM_ISR();
+	if (signalSlow(s)) *higherPriorityTaskWoken = true;
+	ENABLE_INTERRUPTS_FROM_ISR(previous);
+}
+
+void queue_set_add_semaphore(queueset_t set, csemaphore_t s) {
+	s->set = set;
 }
@@ -1,3 +1,9 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "lists.h"
+#include "scheduler.h"
+#include "queue.h"
+
 #ifndef __SEMAPHORE_H
 #define __SEMAPHORE_H
 typedef volatile unsigned int semaphore_t;
@@ -5,4 +11,80 @@ typedef volatile unsigned int semaphore_t;
 void OS_WaitNaive(semaphore_t* s);
 void OS_SignalNaive(semaphore_t* s);
 
-#endif
\ No newline at end of file
+/*
+ * Same as OS_WaitNaive, but gives up after ticks system ticks.
+ * Returns true if the semaphore was taken, false on timeout.
+ * ticks = 0 only tries once, ticks = OS_WAIT_FOREVER never times out.
+ * DEPRECATED: a naive semaphore has no wait list to block on, so this
+ * polls, sleeping a tick between tries: a signal can go unnoticed for up
+ * to a tick, and a waiter wakes every tick until it gets the count. Use a
+ * csemaphore_t and OS_WaitTimeout, which block until signalled.
+ */
+__attribute__((deprecated("polls every tick, use OS_WaitTimeout")))
+bool OS_WaitNaiveTimeout(semaphore_t* s, uint32_t ticks);
+
+/*
+ * Blocking counting semaphore: threads waiting on it are taken off the 
+ * ready lists, and each signal wakes exactly one of them, in the order
+ * chosen when the semaphore was created.
+ * Taking an available count and signalling with nobody waiting never 
+ * mask interrupts, only blocking and waking go through the scheduler.
+ */
+struct semaphore
+{
+    // count in the low half, number of blocked threads in the high half, 
+    // packed so that both fast paths are a single exclusive load/store
+    volatile uint32_t state;
+    list_t waitList;        // threads blocked on the semaphore
+    waitOrder_t order;
+    struct queueSet* set;   // set this semaphore is a member of, NULL if none
+};
+
+#define SEMAPHORE_MAX_COUNT (0xFFFF)
+
+// unpacking state
+#define SEM_COUNT(state)	((state) & 0xFFFF)
+#define SEM_WAITERS(state)	((state) >> 16)
+#define SEM_ONE_WAITER		(1 << 16)
+
+typedef struct semaphore *csemaphore_t;
+
+/*
+ * REQUIRES: count <= SEMAPHORE_MAX_COUNT
+ */
+csemaphore_t create_semaphore(uint32_t count, waitOrder_t order);
+
+/*
+ * REQUIRES: no thread is blocked on the semaphore
+ */
+void free_semaphore(csemaphore_t s);
+
+void OS_Wait(csemaphore_t s);
+
+/*
+ * Same as OS_Wait, but gives up after ticks system ticks.
+ * Returns true if the semaphore was taken, false on timeout.
+ */
+bool OS_WaitTimeout(csemaphore_t s, uint32_t ticks);
+
+/*
+ * Hands the count straight to the first waiter if there is one.
+ * A count already at SEMAPHORE_MAX_COUNT stays there.
+ */
+void OS_Signal(csemaphore_t s);
+
+/*
+ * OS_Signal for interrupt handlers, never blocks.
+ * Sets *higherPriorityTaskWoken if the woken thread outranks the 
+ * interrupted one, pass it to OS_YIELD_FROM_ISR at the end of the handler.
+ * OS_SignalNaive is also safe to call from handlers.
+ */
+void OS_SignalFromISR(csemaphore_t s, bool* higherPriorityTaskWoken);
+
+/*
+ * adds s to a queue set, every count it gains is then posted to the set
+ * REQUIRES: the count is 0 and s is not a member of another set
+ */
+void queue_set_add_semaphore(queueset_t set, csemaphore_t s);
+
+#endif
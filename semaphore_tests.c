@@ -0,0 +1,51 @@
+#include "semaphore.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "staticMalloc.h"
+
+void saturationTests();
+
+char mallocArray[1000];
+
+int main() {
+    printf("Running tests...\n");
+    initMalloc(mallocArray, sizeof(mallocArray));
+    initReadyLists();
+    printf("Running semaphore saturation tests...");
+    saturationTests();
+    printf(" Passed!\n");
+    printf("All tests passed!\n");
+    return 0;
+}
+
+/*
+ * signalling past SEMAPHORE_MAX_COUNT must not carry into the waiter
+ * count, on the fast path or the slow one (a semaphore in a set)
+ */
+void saturationTests() {
+    bool woken = false;
+    csemaphore_t s = create_semaphore(SEMAPHORE_MAX_COUNT - 2, WAIT_ORDER_PRIORITY);
+    for (int i = 0; i < 4; i++) {
+        OS_Signal(s);
+        assert(SEM_WAITERS(s->state) == 0);
+    }
+    OS_SignalFromISR(s, &woken);
+    assert(SEM_COUNT(s->state) == SEMAPHORE_MAX_COUNT);
+    assert(SEM_WAITERS(s->state) == 0);
+    assert(!woken);
+    // the count is still usable after saturating
+    assert(OS_WaitTimeout(s, 0));
+    assert(SEM_COUNT(s->state) == SEMAPHORE_MAX_COUNT - 1);
+    free_semaphore(s);
+
+    queueset_t set = create_queue_set(2);
+    s = create_semaphore(0, WAIT_ORDER_PRIORITY);
+    s->state = SEMAPHORE_MAX_COUNT - 1;
+    queue_set_add_semaphore(set, s);
+    for (int i = 0; i < 3; i++) {
+        OS_Signal(s);
+        assert(SEM_WAITERS(s->state) == 0);
+    }
+    assert(SEM_COUNT(s->state) == SEMAPHORE_MAX_COUNT);
+}
@@ -72,3 +72,17 @@ void SerialWriteInt(int n)
     SerialWriteLine(ch);
 }
 
+void SerialWriteUnsigned(unsigned int n)
+{
+    char str[11];
+    int i = 10;
+    str[i] = 0;
+    do
+    {
+        i--;
+        str[i] = '0'+n%10;
+        n = n/10;
+    } while (n>0);
+    SerialWrite(&str[i]);
+}
+
@@ -12,4 +12,6 @@ void SetupSerial();
 void SerialWrite(char*);
 void SerialWriteInt(int);
 void SerialWriteLine(char*);
+// writes n in decimal, without a newline
+void SerialWriteUnsigned(unsigned int);
 #endif /* SERIAL_H_ */
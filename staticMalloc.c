@@ -2,6 +2,7 @@
 #include "staticMalloc.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 
 // choose a convenient alignment for all malloced addresses for testing purposes
 #define ALIGNMENT_REQ 16
@@ -29,7 +30,7 @@ void initMalloc(char *start, int heap_size) {
     memPointer = mallocArrayStart;
     heapSize = heap_size;
     freeList = NULL;
-    while ((unsigned int)memPointer % ALIGNMENT_REQ != 12) memPointer++;
+    while ((uintptr_t)memPointer % ALIGNMENT_REQ != 12) memPointer++;
 }
 
 
@@ -54,7 +55,7 @@ void *Malloc(int size) {
     *(int *)res = size;
     res += 4;
     memPointer += 4 + size;
-    while ((unsigned int)memPointer % ALIGNMENT_REQ != 12) memPointer++;
+    while ((uintptr_t)memPointer % ALIGNMENT_REQ != 12) memPointer++;
     if ((unsigned long)memPointer - (unsigned long)mallocArrayStart > heapSize) {
         //printf("memPointer %i\n", (unsigned int)memPointer);
         //printf("mallocArray %i\n", (unsigned int)mallocArrayStart);
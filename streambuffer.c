@@ -0,0 +1,147 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include "streambuffer.h"
+#include <stdlib.h>
+
+streambuffer_t create_stream_buffer(void* storage, uint32_t size, uint32_t triggerLevel) {
+    streambuffer_t res = MALLOC(sizeof(struct streamBuffer));
+    if (!res) return NULL;
+    res->storage = storage;
+    res->size = size;
+    res->head = 0;
+    res->tail = 0;
+    res->triggerLevel = triggerLevel;
+    res->readerTrigger = triggerLevel;
+    res->readerWait = NULL;
+    res->writerWait = NULL;
+    return res;
+}
+
+void free_stream_buffer(streambuffer_t stream) {
+    FREE(stream);
+}
+
+uint32_t stream_buffer_available(streambuffer_t stream) {
+    // the indices are free running, so this holds across wrap around too
+    return stream->tail - stream->head;
+}
+
+static uint32_t minimum(uint32_t a, uint32_t b) {
+    return (a < b) ? a : b;
+}
+
+/*
+ * writer side: copies in what fits, then publishes the new tail
+ */
+static uint32_t writeBytes(streambuffer_t stream, const uint8_t* data, uint32_t len) {
+    uint32_t tail = stream->tail;
+    uint32_t n = minimum(len, stream->size - (tail - stream->head));
+    for (uint32_t i = 0; i < n; i++)
+        stream->storage[(tail + i) & (stream->size - 1)] = data[i];
+    // the bytes have to land before the reader can see the new tail
+    DATA_MEMORY_BARRIER();
+    stream->tail = tail + n;
+    DATA_MEMORY_BARRIER();
+    return n;
+}
+
+/*
+ * reader side: copies out up to len bytes, then publishes the new head
+ */
+static uint32_t readBytes(streambuffer_t stream, uint8_t* buffer, uint32_t len) {
+    uint32_t head = stream->head;
+    uint32_t n = minimum(len, stream->tail - head);
+    DATA_MEMORY_BARRIER();
+    for (uint32_t i = 0; i < n; i++)
+        buffer[i] = stream->storage[(head + i) & (stream->size - 1)];
+    DATA_MEMORY_BARRIER();
+    stream->head = head + n;
+    DATA_MEMORY_BARRIER();
+    return n;
+}
+
+/*
+ * wakes the blocked reader if its trigger level is reached,
+ * returns true if it outranks the running thread
+ * REQUIRES: interrupts are disabled
+ */
+static bool wakeReader(streambuffer_t stream) {
+    TCB_t* reader = OS_waitListHead(stream->readerWait);
+    if (reader == NULL || stream_buffer_available(stream) < stream->readerTrigger) 
+        return false;
+    return OS_unblockTaskFromISR(reader);
+}
+
+/*
+ * checked without a lock first, so interrupts are only masked when 
+ * there is a reader to wake
+ */
+static bool readerNeedsWaking(streambuffer_t stream) {
+    return stream->readerWait != NULL && 
+           stream_buffer_available(stream) >= stream->readerTrigger;
+}
+
+uint32_t stream_buffer_send(streambuffer_t stream, const void* data, uint32_t len, uint32_t ticks) {
+    const uint8_t* bytes = data;
+    uint32_t start = xTickCount;
+    uint32_t sent = 0;
+    while (1) {
+        sent += writeBytes(stream, &bytes[sent], len - sent);
+        if (readerNeedsWaking(stream)) {
+            DISABLE_INTERRUPTS();
+            bool switchNeeded = wakeReader(stream);
+            ENABLE_INTERRUPTS();
+            if (switchNeeded) OS_yield();
+        }
+        if (sent == len || ticks == 0) return sent;
+
+        uint32_t remaining = OS_WAIT_FOREVER;
+        if (ticks != OS_WAIT_FOREVER) {
+            uint32_t elapsed = xTickCount - start;
+            if (elapsed >= ticks) return sent;
+            remaining = ticks - elapsed;
+        }
+        // the reader checks for us after moving head, so recheck for room 
+        // with interrupts disabled before blocking
+        DISABLE_INTERRUPTS();
+        if (stream_buffer_available(stream) == stream->size)
+            OS_blockCurrentTask(&stream->writerWait, remaining);
+        ENABLE_INTERRUPTS();
+    }
+}
+
+uint32_t stream_buffer_send_from_isr(streambuffer_t stream, const void* data, uint32_t len,
+                                     bool* higherPriorityTaskWoken) {
+    uint32_t sent = writeBytes(stream, data, len);
+    if (readerNeedsWaking(stream)) {
+        uint32_t previous = DISABLE_INTERRUPTS_FROM_ISR();
+        if (wakeReader(stream)) *higherPriorityTaskWoken = true;
+        ENABLE_INTERRUPTS_FROM_ISR(previous);
+    }
+    return sent;
+}
+
+uint32_t stream_buffer_receive(streambuffer_t stream, void* buffer, uint32_t len, uint32_t ticks) {
+    uint32_t trigger = minimum(stream->triggerLevel, len);
+    if (stream_buffer_available(stream) < trigger && ticks != 0) {
+        // the writer checks for us after moving tail, so recheck with
+        // interrupts disabled before blocking
+        DISABLE_INTERRUPTS();
+        stream->readerTrigger = trigger;
+        if (stream_buffer_available(stream) < trigger)
+            OS_blockCurrentTask(&stream->readerWait, ticks);
+        ENABLE_INTERRUPTS();
+    }
+
+    uint32_t n = readBytes(stream, buffer, len);
+    if (n > 0 && stream->writerWait != NULL) {
+        DISABLE_INTERRUPTS();
+        bool switchNeeded = false;
+        TCB_t* writer = OS_waitListHead(stream->writerWait);
+        if (writer != NULL) switchNeeded = OS_unblockTaskFromISR(writer);
+        ENABLE_INTERRUPTS();
+        if (switchNeeded) OS_yield();
+    }
+    return n;
+}
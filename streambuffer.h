@@ -0,0 +1,68 @@
+#include "lists.h"
+#include "staticMalloc.h"
+#include "scheduler.h"
+#include <stdlib.h>
+
+#ifndef STREAM_BUFFERS
+#define STREAM_BUFFERS
+
+/*
+ * Single producer, single consumer byte stream, e.g. between a UART 
+ * interrupt handler and a thread, or between SerialWrite callers and
+ * a logging thread.
+ * The head and tail indices are each only moved by one side, so moving
+ * bytes never needs a lock or masks interrupts. The kernel is only
+ * entered to block, and to wake the reader once trigger level bytes
+ * are available (rather than on every byte) or a blocked writer once
+ * there is room.
+ */
+struct streamBuffer
+{
+    uint8_t* storage;
+    uint32_t size;              // a power of two
+    volatile uint32_t head;     // free running read index, only moved by the reader
+    volatile uint32_t tail;     // free running write index, only moved by the writer
+    uint32_t triggerLevel;      // bytes a blocked reader waits for
+    volatile uint32_t readerTrigger;    // bytes the blocked reader is waiting for
+    list_t readerWait;          // the reader, while blocked
+    list_t writerWait;          // the writer, while blocked on a full buffer
+};
+
+typedef struct streamBuffer *streambuffer_t;
+
+/*
+ * REQUIRES: size is a power of two, storage holds size bytes
+ *           1 <= triggerLevel <= size
+ */
+streambuffer_t create_stream_buffer(void* storage, uint32_t size, uint32_t triggerLevel);
+
+/*
+ * REQUIRES: no thread is blocked on the stream buffer
+ */
+void free_stream_buffer(streambuffer_t stream);
+
+/*
+ * Writes len bytes from data, blocking for up to ticks system ticks 
+ * while the buffer is full. Returns the number of bytes written, less
+ * than len on timeout.
+ */
+uint32_t stream_buffer_send(streambuffer_t stream, const void* data, uint32_t len, uint32_t ticks);
+
+/*
+ * Non-blocking stream_buffer_send for interrupt handlers, writes what fits.
+ * See OS_SignalFromISR for higherPriorityTaskWoken.
+ */
+uint32_t stream_buffer_send_from_isr(streambuffer_t stream, const void* data, uint32_t len,
+                                     bool* higherPriorityTaskWoken);
+
+/*
+ * Waits for up to ticks system ticks until the trigger level (or len, 
+ * if smaller) bytes are available, then reads up to len bytes into buffer.
+ * Returns the number of bytes read, which can be less than the trigger
+ * level (even 0) on timeout.
+ */
+uint32_t stream_buffer_receive(streambuffer_t stream, void* buffer, uint32_t len, uint32_t ticks);
+
+uint32_t stream_buffer_available(streambuffer_t stream);
+
+#endif
@@ -0,0 +1,86 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "serial.h"
+#include "scheduler.h"
+#include "mutex.h"
+#include "queue.h"
+#include "stresstest.h"
+
+#define STRESS_STACK_SIZE 256
+#define STRESS_WORKERS 8
+#define STRESS_QUEUE_LENGTH 4
+#define STRESS_PRODUCER_TID 201
+#define STRESS_CONSUMER_TID 202
+
+static mutex_t stressMutex;
+static volatile uint32_t inside = 0;
+static volatile uint32_t violations = 0;
+static volatile uint32_t acquisitions[STRESS_WORKERS];
+
+static queue_t stressQueue;
+static QUEUE_STORAGE(stressQueueStorage, sizeof(uint32_t), STRESS_QUEUE_LENGTH);
+static volatile uint32_t received = 0;
+
+/*
+ * workers at two priorities fight over one mutex, yielding and
+ * sleeping every so often to shake up the interleavings
+ */
+static void stressWorker(void) {
+	uint32_t id = pxCurrentTCB->uxThreadId;
+	while (1) {
+		acquire_mutex(stressMutex, id, pxCurrentTCB->uxPriority);
+		if (inside++ != 0) violations++;
+		if ((acquisitions[id] & 7) == 0) OS_yield();
+		inside--;
+		release_mutex(stressMutex, id, pxCurrentTCB->uxPriority);
+		acquisitions[id]++;
+		if ((acquisitions[id] & 63) == 0) OS_Delay(1);
+	}
+}
+
+static void stressProducer(void) {
+	uint32_t sequence = 0;
+	while (1) {
+		queue_send(stressQueue, &sequence, OS_WAIT_FOREVER);
+		sequence++;
+	}
+}
+
+static void stressConsumer(void) {
+	uint32_t expected = 0;
+	while (1) {
+		uint32_t sequence;
+		queue_receive(stressQueue, &sequence, OS_WAIT_FOREVER);
+		if (sequence != expected) violations++;
+		expected = sequence + 1;
+		received++;
+	}
+}
+
+void STRESS_start(void) {
+	stressMutex = create_mutex();
+	stressQueue = create_queue(stressQueueStorage, sizeof(uint32_t), STRESS_QUEUE_LENGTH);
+	for (int i = 0; i < STRESS_WORKERS; i++)
+		OS_spawnThread(&stressWorker, i, STRESS_STACK_SIZE, 1 + (i & 1));
+	OS_spawnThread(&stressProducer, STRESS_PRODUCER_TID, STRESS_STACK_SIZE, 2);
+	OS_spawnThread(&stressConsumer, STRESS_CONSUMER_TID, STRESS_STACK_SIZE, 1);
+}
+
+bool STRESS_report(void) {
+	uint32_t total = 0;
+	for (int i = 0; i < STRESS_WORKERS; i++) {
+		SerialWrite("worker ");
+		SerialWriteUnsigned(i);
+		SerialWrite(" acquisitions: ");
+		SerialWriteUnsigned(acquisitions[i]);
+		SerialWriteLine("");
+		total += acquisitions[i];
+	}
+	SerialWrite("messages received: ");
+	SerialWriteUnsigned(received);
+	SerialWriteLine("");
+	SerialWrite("violations: ");
+	SerialWriteUnsigned(violations);
+	SerialWriteLine("");
+	return violations == 0 && total != 0 && received != 0;
+}
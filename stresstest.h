@@ -0,0 +1,17 @@
+#ifndef STRESSTEST_H
+#define STRESSTEST_H
+#include <stdbool.h>
+
+/*
+ * Stress test of the kernel for the simulation and emulator builds:
+ * workers at two priorities fight over one mutex while a producer and a
+ * consumer pass sequence numbers through a queue.
+ * STRESS_start spawns the threads (with interrupts disabled, before
+ * OS_startScheduler), STRESS_report prints what they did over the serial
+ * port and returns false if it caught a thread inside the mutex alongside
+ * another one, a queue message out of order, or no progress at all.
+ */
+void STRESS_start(void);
+bool STRESS_report(void);
+
+#endif /* STRESSTEST_H */
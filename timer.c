@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "15348.h"
+#include "timer.h"
 
 
 void SystickInit()
@@ -68,3 +69,9 @@ void SysTick_Wait1microsec(uint32_t delay)
            SysTick_Wait(80);
 }
 
+void CycleCounterInit()
+{
+    DEMCR_R |= DEMCR_TRCENA;
+    DWT_CYCCNT_R = 0;
+    DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;
+}
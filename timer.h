@@ -22,5 +22,15 @@ void SysTick_Wait1ms(uint32_t delay);
 // busy-waiting for 100 microseconds
 void SysTick_Wait100microsec(uint32_t delay);
 
+// DWT cycle counter, free running at the CPU clock once initialized
+#define DEMCR_R             (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL_R          (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT_R        (*((volatile uint32_t *)0xE0001004))
+#define DEMCR_TRCENA        0x01000000  // enables the DWT unit
+#define DWT_CTRL_CYCCNTENA  0x00000001  // enables the cycle counter
+
+// starts the cycle counter, read with CYCLE_COUNT (portmacro.h)
+void CycleCounterInit();
+
 
 #endif /* TIMER_H_ */
@@ -0,0 +1,100 @@
+#include "lists.h"
+#include "scheduler.h"
+#include "topic.h"
+#include <stdlib.h>
+
+/*
+ * word copies when the caller's buffer is aligned, byte copies otherwise
+ */
+static void copyValue(void* dst, const void* src, uint32_t size) {
+    if ((((uintptr_t)dst | (uintptr_t)src | size) & 3) == 0) {
+        uint32_t* d = dst;
+        const uint32_t* s = src;
+        for (uint32_t i = 0; i < (size >> 2); i++) d[i] = s[i];
+        return;
+    }
+    uint8_t* d = dst;
+    const uint8_t* s = src;
+    for (uint32_t i = 0; i < size; i++) d[i] = s[i];
+}
+
+/*
+ * writes the slot readers are not using, then makes it current
+ */
+static void writeSlot(topic_t* topic, const void* value) {
+    uint32_t next = topic->version + 1;
+    copyValue(&topic->slots[(next & 1) * (topic->stride >> 2)], value, topic->size);
+    DATA_MEMORY_BARRIER();
+    topic->version = next;
+    DATA_MEMORY_BARRIER();
+}
+
+/*
+ * wakes every blocked subscriber, returns true if one outranks the
+ * running thread
+ * REQUIRES: interrupts are disabled
+ */
+static bool wakeSubscribers(topic_t* topic) {
+    bool switchNeeded = false;
+    while (topic->waitList != NULL) {
+        if (OS_unblockTaskFromISR(OS_waitListHead(topic->waitList)))
+            switchNeeded = true;
+    }
+    return switchNeeded;
+}
+
+void topic_publish(topic_t* topic, const void* value) {
+    writeSlot(topic, value);
+    if (topic->waitList == NULL) return;
+
+    DISABLE_INTERRUPTS();
+    bool switchNeeded = wakeSubscribers(topic);
+    ENABLE_INTERRUPTS();
+    if (switchNeeded) OS_yield();
+}
+
+void topic_publish_from_isr(topic_t* topic, const void* value, bool* higherPriorityTaskWoken) {
+    writeSlot(topic, value);
+    if (topic->waitList == NULL) return;
+
+    uint32_t previous = DISABLE_INTERRUPTS_FROM_ISR();
+    if (wakeSubscribers(topic)) *higherPriorityTaskWoken = true;
+    ENABLE_INTERRUPTS_FROM_ISR(previous);
+}
+
+bool topic_read(subscriber_t* sub, void* buffer) {
+    topic_t* topic = sub->topic;
+    uint32_t version;
+    do {
+        version = topic->version;
+        if (version == 0) return false;
+        DATA_MEMORY_BARRIER();
+        copyValue(buffer, &topic->slots[(version & 1) * (topic->stride >> 2)], topic->size);
+        DATA_MEMORY_BARRIER();
+        // retry if a publish landed while copying, the second one would
+        // have rewritten the slot being read
+    } while (topic->version != version);
+    sub->seen = version;
+    return true;
+}
+
+bool topic_updated(subscriber_t* sub) {
+    return sub->topic->version != sub->seen;
+}
+
+bool topic_wait(subscriber_t* sub, void* buffer, uint32_t ticks) {
+    topic_t* topic = sub->topic;
+    DISABLE_INTERRUPTS();
+    if (topic->version == sub->seen) {
+        if (ticks == 0) {
+            ENABLE_INTERRUPTS();
+            return false;
+        }
+        OS_blockCurrentTask(&topic->waitList, ticks);
+        ENABLE_INTERRUPTS();
+        if (pxCurrentTCB->xTimedOut) return false;
+    } else {
+        ENABLE_INTERRUPTS();
+    }
+    return topic_read(sub, buffer);
+}
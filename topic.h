@@ -0,0 +1,83 @@
+#include "lists.h"
+#include "scheduler.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TOPICS
+#define TOPICS
+
+/*
+ * Publish/subscribe topics: a publisher writes the latest value once and
+ * any number of subscribers read it, with no per-subscriber queue or copy.
+ * Subscribers only ever see the newest value, older ones are overwritten.
+ *
+ * The value is kept in two slots and version says which one is current
+ * (version & 1). A publish writes the other slot and then bumps version,
+ * so a reader never waits on a write in progress (which on one core would
+ * be a preempted lower priority publisher), it only retries if the version
+ * moved while it was copying.
+ * Each topic has a single publisher, a thread or an interrupt handler.
+ */
+struct topic
+{
+    uint32_t* slots;            // two slots of stride bytes each
+    uint32_t size;              // value size in bytes
+    uint32_t stride;            // size rounded up to a word
+    volatile uint32_t version;  // number of publishes so far
+    list_t waitList;            // subscribers blocked in topic_wait
+};
+
+typedef struct topic topic_t;
+
+/*
+ * Subscriber state: the version last read, kept by the subscriber so the
+ * topic needs no table of subscribers.
+ */
+struct subscriber
+{
+    topic_t* topic;
+    uint32_t seen;
+};
+
+typedef struct subscriber subscriber_t;
+
+/*
+ * Statically declares topic_t name carrying values of size bytes, e.g.
+ * TOPIC(imuTopic, sizeof(struct imuSample));
+ */
+#define TOPIC(name, size) \
+    static uint32_t name##Slots[2 * (((size) + 3) / 4)]; \
+    topic_t name = { name##Slots, (size), ((size) + 3) & ~3UL, 0, NULL }
+
+/*
+ * Statically declares subscriber_t name on topic, e.g.
+ * SUBSCRIBER(telemetryImu, imuTopic);
+ */
+#define SUBSCRIBER(name, topic) \
+    subscriber_t name = { &(topic), 0 }
+
+void topic_publish(topic_t* topic, const void* value);
+
+/*
+ * topic_publish for interrupt handlers, see OS_SignalFromISR
+ */
+void topic_publish_from_isr(topic_t* topic, const void* value, bool* higherPriorityTaskWoken);
+
+/*
+ * Copies the latest value into buffer and marks it as seen.
+ * Returns false (leaving buffer alone) if nothing was published yet.
+ */
+bool topic_read(subscriber_t* sub, void* buffer);
+
+/*
+ * true if something was published since sub last read, for polling
+ */
+bool topic_updated(subscriber_t* sub);
+
+/*
+ * Blocks for up to ticks system ticks until there is a value sub has not
+ * seen, then reads it like topic_read. Returns false on timeout.
+ */
+bool topic_wait(subscriber_t* sub, void* buffer, uint32_t ticks);
+
+#endif